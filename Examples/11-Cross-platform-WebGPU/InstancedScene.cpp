@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Scene.h"
+
+// Draws `instanceCount` small billboards stored in a per-instance storage
+// buffer. Every frame a compute pass frustum-culls all instances on the GPU,
+// compacts the visible indices and writes the instance count of the
+// DrawIndirect arguments. The CPU only updates the camera uniform and
+// records a fixed number of commands, whatever the instance count.
+
+namespace {
+
+const char cullShaderCode[] = R"(
+    struct Instance {
+        position : vec3f,
+        radius : f32,
+        color : vec4f,
+    };
+
+    struct Camera {
+        viewProj : mat4x4f,
+        planes : array<vec4f, 6>,
+        scale : vec2f,
+        count : u32,
+    };
+
+    struct DrawArgs {
+        vertexCount : u32,
+        instanceCount : atomic<u32>,
+        firstVertex : u32,
+        firstInstance : u32,
+    };
+
+    @group(0) @binding(0) var<storage, read> instances : array<Instance>;
+    @group(0) @binding(1) var<storage, read_write> visible : array<u32>;
+    @group(0) @binding(2) var<uniform> camera : Camera;
+    @group(0) @binding(3) var<storage, read_write> drawArgs : DrawArgs;
+
+    var<workgroup> groupCount : atomic<u32>;
+    var<workgroup> groupBase : u32;
+
+    @compute @workgroup_size(256)
+    fn main(@builtin(global_invocation_id) globalId : vec3u,
+            @builtin(local_invocation_index) localIndex : u32,
+            @builtin(num_workgroups) groups : vec3u) {
+        let i = globalId.x + globalId.y * groups.x * 256u;
+
+        var isVisible = i < camera.count;
+        if (isVisible) {
+            let instance = instances[i];
+            for (var p = 0u; p < 6u; p = p + 1u) {
+                let plane = camera.planes[p];
+                if (dot(plane.xyz, instance.position) + plane.w < -instance.radius) {
+                    isVisible = false;
+                }
+            }
+        }
+
+        // Compact within the workgroup first, so only one invocation per
+        // workgroup touches the global counter.
+        var localSlot = 0u;
+        if (isVisible) {
+            localSlot = atomicAdd(&groupCount, 1u);
+        }
+        workgroupBarrier();
+        if (localIndex == 0u) {
+            groupBase = atomicAdd(&drawArgs.instanceCount, atomicLoad(&groupCount));
+        }
+        let base = workgroupUniformLoad(&groupBase);
+        if (isVisible) {
+            visible[base + localSlot] = i;
+        }
+    }
+)";
+
+const char renderShaderCode[] = R"(
+    struct Instance {
+        position : vec3f,
+        radius : f32,
+        color : vec4f,
+    };
+
+    struct Camera {
+        viewProj : mat4x4f,
+        planes : array<vec4f, 6>,
+        scale : vec2f,
+        count : u32,
+    };
+
+    struct VertexOut {
+        @builtin(position) position : vec4f,
+        @location(0) color : vec4f,
+    };
+
+    @group(0) @binding(0) var<storage, read> instances : array<Instance>;
+    @group(0) @binding(1) var<storage, read> visible : array<u32>;
+    @group(0) @binding(2) var<uniform> camera : Camera;
+
+    @vertex fn vertexMain(@builtin(vertex_index) v : u32,
+                          @builtin(instance_index) n : u32) -> VertexOut {
+        const corners = array(vec2f(0, 1), vec2f(-0.866, -0.5), vec2f(0.866, -0.5));
+        let instance = instances[visible[n]];
+        let center = camera.viewProj * vec4f(instance.position, 1);
+
+        var out : VertexOut;
+        out.position = vec4f(center.xy + corners[v] * instance.radius * camera.scale,
+                             center.zw);
+        out.color = instance.color;
+        return out;
+    }
+
+    @fragment fn fragmentMain(@location(0) color : vec4f) -> @location(0) vec4f {
+        return color;
+    }
+)";
+
+struct Instance {
+  float position[3];
+  float radius;
+  float color[4];
+};
+
+// Host-side mirror of the Camera uniform.
+struct Camera {
+  float viewProj[16];
+  float planes[6][4];
+  float scale[2];
+  uint32_t count;
+  uint32_t pad;
+};
+
+// Column-major 4x4 matrices, as WGSL expects them.
+using Mat4 = std::array<float, 16>;
+
+Mat4 Multiply(const Mat4 &a, const Mat4 &b) {
+  Mat4 result{};
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      for (int k = 0; k < 4; ++k) {
+        result[col * 4 + row] += a[k * 4 + row] * b[col * 4 + k];
+      }
+    }
+  }
+  return result;
+}
+
+// Right-handed, looking down -z, depth in [0, 1].
+Mat4 Perspective(float fovY, float aspect, float nearZ, float farZ) {
+  const float f = 1.0f / std::tan(fovY / 2.0f);
+  Mat4 m{};
+  m[0] = f / aspect;
+  m[5] = f;
+  m[10] = farZ / (nearZ - farZ);
+  m[11] = -1.0f;
+  m[14] = nearZ * farZ / (nearZ - farZ);
+  return m;
+}
+
+// View matrix of a camera at the origin turned by `yaw` around the y axis.
+Mat4 RotationY(float yaw) {
+  const float c = std::cos(yaw);
+  const float s = std::sin(yaw);
+  Mat4 m{};
+  m[0] = c;
+  m[2] = s;
+  m[5] = 1.0f;
+  m[8] = -s;
+  m[10] = c;
+  m[15] = 1.0f;
+  return m;
+}
+
+// Gribb-Hartmann frustum planes of clip = m * p, normalized so that
+// dot(plane.xyz, p) + plane.w is the signed distance to the plane.
+void ExtractPlanes(const Mat4 &m, float planes[6][4]) {
+  auto row = [&](int r, int c) { return m[c * 4 + r]; };
+  for (int c = 0; c < 4; ++c) {
+    planes[0][c] = row(3, c) + row(0, c); // left
+    planes[1][c] = row(3, c) - row(0, c); // right
+    planes[2][c] = row(3, c) + row(1, c); // bottom
+    planes[3][c] = row(3, c) - row(1, c); // top
+    planes[4][c] = row(2, c);             // near
+    planes[5][c] = row(3, c) - row(2, c); // far
+  }
+  for (int p = 0; p < 6; ++p) {
+    const float length =
+        std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] +
+                  planes[p][2] * planes[p][2]);
+    for (int c = 0; c < 4; ++c) {
+      planes[p][c] /= length;
+    }
+  }
+}
+
+class InstancedScene : public Scene {
+public:
+  InstancedScene(const wgpu::Device &device, wgpu::TextureFormat format,
+                 uint32_t instanceCount)
+      : device_(device), instanceCount_(instanceCount) {
+    // Keep the density constant as the scene grows.
+    extent_ = 2.0f * std::cbrt(float(instanceCount));
+
+    CreateBuffers();
+    CreateCullPipeline();
+    CreateRenderPipeline(format);
+  }
+
+  void Encode(const wgpu::CommandEncoder &encoder,
+              const FrameTarget &target) override {
+    UpdateCamera(target);
+
+    encoder.CopyBufferToBuffer(resetArgsBuffer_, 0, drawArgsBuffer_, 0,
+                               4 * sizeof(uint32_t));
+
+    wgpu::ComputePassTimestampWrites computeTimestamps{};
+    wgpu::ComputePassDescriptor computePassDesc{
+        .timestampWrites =
+            PassTimestamps(target, true, false, &computeTimestamps)};
+    wgpu::ComputePassEncoder cullPass =
+        encoder.BeginComputePass(&computePassDesc);
+    cullPass.SetPipeline(cullPipeline_);
+    cullPass.SetBindGroup(0, cullBindGroup_);
+    cullPass.DispatchWorkgroups(groupsX_, groupsY_);
+    cullPass.End();
+
+    wgpu::RenderPassColorAttachment attachment{
+        .view = target.view,
+        .loadOp = wgpu::LoadOp::Clear,
+        .storeOp = wgpu::StoreOp::Store};
+    wgpu::RenderPassTimestampWrites renderTimestamps{};
+    wgpu::RenderPassDescriptor renderpass{
+        .colorAttachmentCount = 1,
+        .colorAttachments = &attachment,
+        .timestampWrites =
+            PassTimestamps(target, false, true, &renderTimestamps)};
+    wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&renderpass);
+    pass.SetPipeline(renderPipeline_);
+    pass.SetBindGroup(0, renderBindGroup_);
+    pass.DrawIndirect(drawArgsBuffer_, 0);
+    pass.End();
+  }
+
+private:
+  void CreateBuffers() {
+    const uint64_t instanceBytes = uint64_t(instanceCount_) * sizeof(Instance);
+    wgpu::BufferDescriptor instanceDesc{.usage = wgpu::BufferUsage::Storage,
+                                        .size = instanceBytes,
+                                        .mappedAtCreation = true};
+    instanceBuffer_ = device_.CreateBuffer(&instanceDesc);
+
+    // Filled once at startup; nothing on the CPU looks at instances again.
+    Instance *instances =
+        static_cast<Instance *>(instanceBuffer_.GetMappedRange());
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-extent_, extent_);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (uint32_t i = 0; i < instanceCount_; ++i) {
+      instances[i] = Instance{
+          .position = {position(rng), position(rng), position(rng)},
+          .radius = 0.25f + 0.5f * unit(rng),
+          .color = {unit(rng), unit(rng), unit(rng), 1.0f}};
+    }
+    instanceBuffer_.Unmap();
+
+    wgpu::BufferDescriptor visibleDesc{
+        .usage = wgpu::BufferUsage::Storage,
+        .size = uint64_t(instanceCount_) * sizeof(uint32_t)};
+    visibleBuffer_ = device_.CreateBuffer(&visibleDesc);
+
+    wgpu::BufferDescriptor cameraDesc{.usage = wgpu::BufferUsage::Uniform |
+                                               wgpu::BufferUsage::CopyDst,
+                                      .size = sizeof(Camera)};
+    cameraBuffer_ = device_.CreateBuffer(&cameraDesc);
+
+    wgpu::BufferDescriptor drawArgsDesc{
+        .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect |
+                 wgpu::BufferUsage::CopyDst,
+        .size = 4 * sizeof(uint32_t)};
+    drawArgsBuffer_ = device_.CreateBuffer(&drawArgsDesc);
+
+    // vertexCount, instanceCount, firstVertex, firstInstance
+    const uint32_t resetArgs[4] = {3, 0, 0, 0};
+    wgpu::BufferDescriptor resetArgsDesc{.usage = wgpu::BufferUsage::CopySrc,
+                                         .size = sizeof(resetArgs),
+                                         .mappedAtCreation = true};
+    resetArgsBuffer_ = device_.CreateBuffer(&resetArgsDesc);
+    std::memcpy(resetArgsBuffer_.GetMappedRange(), resetArgs,
+                sizeof(resetArgs));
+    resetArgsBuffer_.Unmap();
+
+    // Split the dispatch over two dimensions once it exceeds the 65535
+    // workgroups per dimension limit.
+    const uint32_t groups = (instanceCount_ + 255) / 256;
+    groupsX_ = std::min(groups, 65535u);
+    groupsY_ = (groups + groupsX_ - 1) / groupsX_;
+  }
+
+  void CreateCullPipeline() {
+    wgpu::ComputePipelineDescriptor pipelineDesc = {};
+    pipelineDesc.compute.module = CreateShaderModule(device_, cullShaderCode);
+    pipelineDesc.compute.entryPoint = "main";
+    cullPipeline_ = device_.CreateComputePipeline(&pipelineDesc);
+
+    wgpu::BindGroupEntry entries[4] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = instanceBuffer_;
+    entries[1].binding = 1;
+    entries[1].buffer = visibleBuffer_;
+    entries[2].binding = 2;
+    entries[2].buffer = cameraBuffer_;
+    entries[3].binding = 3;
+    entries[3].buffer = drawArgsBuffer_;
+    wgpu::BindGroupDescriptor bindGroupDesc = {};
+    bindGroupDesc.layout = cullPipeline_.GetBindGroupLayout(0);
+    bindGroupDesc.entryCount = 4;
+    bindGroupDesc.entries = entries;
+    cullBindGroup_ = device_.CreateBindGroup(&bindGroupDesc);
+  }
+
+  void CreateRenderPipeline(wgpu::TextureFormat format) {
+    wgpu::ShaderModule shaderModule =
+        CreateShaderModule(device_, renderShaderCode);
+
+    wgpu::ColorTargetState colorTargetState{.format = format};
+    wgpu::FragmentState fragmentState{.module = shaderModule,
+                                      .targetCount = 1,
+                                      .targets = &colorTargetState};
+    wgpu::RenderPipelineDescriptor descriptor{
+        .vertex = {.module = shaderModule}, .fragment = &fragmentState};
+    renderPipeline_ = device_.CreateRenderPipeline(&descriptor);
+
+    wgpu::BindGroupEntry entries[3] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = instanceBuffer_;
+    entries[1].binding = 1;
+    entries[1].buffer = visibleBuffer_;
+    entries[2].binding = 2;
+    entries[2].buffer = cameraBuffer_;
+    wgpu::BindGroupDescriptor bindGroupDesc = {};
+    bindGroupDesc.layout = renderPipeline_.GetBindGroupLayout(0);
+    bindGroupDesc.entryCount = 3;
+    bindGroupDesc.entries = entries;
+    renderBindGroup_ = device_.CreateBindGroup(&bindGroupDesc);
+  }
+
+  void UpdateCamera(const FrameTarget &target) {
+    const float aspect = float(target.width) / float(target.height);
+    const Mat4 projection =
+        Perspective(1.0472f /* 60 degrees */, aspect, 0.1f, 2.0f * extent_);
+    const Mat4 viewProj =
+        Multiply(projection, RotationY(0.01f * float(target.frameIndex)));
+
+    Camera camera{};
+    std::memcpy(camera.viewProj, viewProj.data(), sizeof(camera.viewProj));
+    ExtractPlanes(viewProj, camera.planes);
+    camera.scale[0] = projection[0];
+    camera.scale[1] = projection[5];
+    camera.count = instanceCount_;
+    device_.GetQueue().WriteBuffer(cameraBuffer_, 0, &camera, sizeof(camera));
+  }
+
+  wgpu::Device device_;
+  uint32_t instanceCount_;
+  float extent_;
+  uint32_t groupsX_ = 1;
+  uint32_t groupsY_ = 1;
+
+  wgpu::Buffer instanceBuffer_;
+  wgpu::Buffer visibleBuffer_;
+  wgpu::Buffer cameraBuffer_;
+  wgpu::Buffer drawArgsBuffer_;
+  wgpu::Buffer resetArgsBuffer_;
+
+  wgpu::ComputePipeline cullPipeline_;
+  wgpu::BindGroup cullBindGroup_;
+  wgpu::RenderPipeline renderPipeline_;
+  wgpu::BindGroup renderBindGroup_;
+};
+
+} // namespace
+
+std::unique_ptr<Scene> CreateInstancedScene(const wgpu::Device &device,
+                                            wgpu::TextureFormat format,
+                                            uint32_t instanceCount) {
+  return std::make_unique<InstancedScene>(device, format, instanceCount);
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <random>
+
+#include "Scene.h"
+
+// Compute-to-render particle system. A compute pass advances the particle
+// state from one storage buffer into the other (ping-pong), and the render
+// pass in the same command buffer draws the freshly written buffer directly
+// as a vertex buffer. Particle data never goes through the host after the
+// initial upload.
+
+namespace {
+
+const char simulateShaderCode[] = R"(
+    struct Particle {
+        position : vec2f,
+        velocity : vec2f,
+    };
+
+    struct SimParams {
+        dt : f32,
+        count : u32,
+    };
+
+    @group(0) @binding(0) var<storage, read> particlesIn : array<Particle>;
+    @group(0) @binding(1) var<storage, read_write> particlesOut : array<Particle>;
+    @group(0) @binding(2) var<uniform> params : SimParams;
+
+    @compute @workgroup_size(256)
+    fn main(@builtin(global_invocation_id) globalId : vec3u,
+            @builtin(num_workgroups) groups : vec3u) {
+        let i = globalId.x + globalId.y * groups.x * 256u;
+        if (i >= params.count) {
+            return;
+        }
+
+        var p = particlesIn[i];
+        // Pull towards the centre, bounce off the edges of clip space.
+        let toCenter = -p.position;
+        p.velocity = p.velocity + toCenter * params.dt;
+        p.position = p.position + p.velocity * params.dt;
+        if (abs(p.position.x) > 1.0) {
+            p.velocity.x = -p.velocity.x;
+            p.position.x = clamp(p.position.x, -1.0, 1.0);
+        }
+        if (abs(p.position.y) > 1.0) {
+            p.velocity.y = -p.velocity.y;
+            p.position.y = clamp(p.position.y, -1.0, 1.0);
+        }
+        particlesOut[i] = p;
+    }
+)";
+
+const char renderShaderCode[] = R"(
+    struct VertexOut {
+        @builtin(position) position : vec4f,
+        @location(0) color : vec4f,
+    };
+
+    @vertex fn vertexMain(@location(0) position : vec2f,
+                          @location(1) velocity : vec2f) -> VertexOut {
+        var out : VertexOut;
+        out.position = vec4f(position, 0, 1);
+        let speed = clamp(length(velocity), 0.0, 1.0);
+        out.color = vec4f(speed, 0.3, 1.0 - speed, 1);
+        return out;
+    }
+
+    @fragment fn fragmentMain(@location(0) color : vec4f) -> @location(0) vec4f {
+        return color;
+    }
+)";
+
+struct Particle {
+  float position[2];
+  float velocity[2];
+};
+
+// Host-side mirror of the SimParams uniform.
+struct SimParams {
+  float dt;
+  uint32_t count;
+};
+
+class ParticleScene : public Scene {
+public:
+  ParticleScene(const wgpu::Device &device, wgpu::TextureFormat format,
+                uint32_t particleCount)
+      : device_(device), particleCount_(particleCount) {
+    CreateBuffers();
+    CreateSimulatePipeline();
+    CreateRenderPipeline(format);
+  }
+
+  void Encode(const wgpu::CommandEncoder &encoder,
+              const FrameTarget &target) override {
+    // Even frames read buffer 0 and write buffer 1, odd frames the reverse.
+    const uint32_t src = target.frameIndex % 2;
+    const uint32_t dst = 1 - src;
+
+    wgpu::ComputePassTimestampWrites computeTimestamps{};
+    wgpu::ComputePassDescriptor computePassDesc{
+        .timestampWrites =
+            PassTimestamps(target, true, false, &computeTimestamps)};
+    wgpu::ComputePassEncoder simulatePass =
+        encoder.BeginComputePass(&computePassDesc);
+    simulatePass.SetPipeline(simulatePipeline_);
+    simulatePass.SetBindGroup(0, simulateBindGroups_[src]);
+    simulatePass.DispatchWorkgroups(groupsX_, groupsY_);
+    simulatePass.End();
+
+    wgpu::RenderPassColorAttachment attachment{
+        .view = target.view,
+        .loadOp = wgpu::LoadOp::Clear,
+        .storeOp = wgpu::StoreOp::Store};
+    wgpu::RenderPassTimestampWrites renderTimestamps{};
+    wgpu::RenderPassDescriptor renderpass{
+        .colorAttachmentCount = 1,
+        .colorAttachments = &attachment,
+        .timestampWrites =
+            PassTimestamps(target, false, true, &renderTimestamps)};
+    wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&renderpass);
+    pass.SetPipeline(renderPipeline_);
+    pass.SetVertexBuffer(0, particleBuffers_[dst]);
+    pass.Draw(particleCount_);
+    pass.End();
+  }
+
+private:
+  void CreateBuffers() {
+    const uint64_t particleBytes = uint64_t(particleCount_) * sizeof(Particle);
+    for (int i = 0; i < 2; ++i) {
+      wgpu::BufferDescriptor particleDesc{
+          .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Vertex,
+          .size = particleBytes,
+          .mappedAtCreation = i == 0};
+      particleBuffers_[i] = device_.CreateBuffer(&particleDesc);
+    }
+
+    Particle *particles =
+        static_cast<Particle *>(particleBuffers_[0].GetMappedRange());
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (uint32_t i = 0; i < particleCount_; ++i) {
+      particles[i] = Particle{.position = {unit(rng), unit(rng)},
+                              .velocity = {0.5f * unit(rng), 0.5f * unit(rng)}};
+    }
+    particleBuffers_[0].Unmap();
+
+    const SimParams params{.dt = 1.0f / 60.0f, .count = particleCount_};
+    wgpu::BufferDescriptor paramsDesc{.usage = wgpu::BufferUsage::Uniform,
+                                      .size = sizeof(params),
+                                      .mappedAtCreation = true};
+    paramsBuffer_ = device_.CreateBuffer(&paramsDesc);
+    std::memcpy(paramsBuffer_.GetMappedRange(), &params, sizeof(params));
+    paramsBuffer_.Unmap();
+
+    const uint32_t groups = (particleCount_ + 255) / 256;
+    groupsX_ = std::min(groups, 65535u);
+    groupsY_ = (groups + groupsX_ - 1) / groupsX_;
+  }
+
+  void CreateSimulatePipeline() {
+    wgpu::ComputePipelineDescriptor pipelineDesc = {};
+    pipelineDesc.compute.module =
+        CreateShaderModule(device_, simulateShaderCode);
+    pipelineDesc.compute.entryPoint = "main";
+    simulatePipeline_ = device_.CreateComputePipeline(&pipelineDesc);
+
+    for (int i = 0; i < 2; ++i) {
+      wgpu::BindGroupEntry entries[3] = {};
+      entries[0].binding = 0;
+      entries[0].buffer = particleBuffers_[i];
+      entries[1].binding = 1;
+      entries[1].buffer = particleBuffers_[1 - i];
+      entries[2].binding = 2;
+      entries[2].buffer = paramsBuffer_;
+      wgpu::BindGroupDescriptor bindGroupDesc = {};
+      bindGroupDesc.layout = simulatePipeline_.GetBindGroupLayout(0);
+      bindGroupDesc.entryCount = 3;
+      bindGroupDesc.entries = entries;
+      simulateBindGroups_[i] = device_.CreateBindGroup(&bindGroupDesc);
+    }
+  }
+
+  void CreateRenderPipeline(wgpu::TextureFormat format) {
+    wgpu::ShaderModule shaderModule =
+        CreateShaderModule(device_, renderShaderCode);
+
+    wgpu::VertexAttribute attributes[2] = {
+        {.format = wgpu::VertexFormat::Float32x2,
+         .offset = offsetof(Particle, position),
+         .shaderLocation = 0},
+        {.format = wgpu::VertexFormat::Float32x2,
+         .offset = offsetof(Particle, velocity),
+         .shaderLocation = 1}};
+    wgpu::VertexBufferLayout vertexBufferLayout{
+        .arrayStride = sizeof(Particle),
+        .stepMode = wgpu::VertexStepMode::Vertex,
+        .attributeCount = 2,
+        .attributes = attributes};
+
+    wgpu::ColorTargetState colorTargetState{.format = format};
+    wgpu::FragmentState fragmentState{.module = shaderModule,
+                                      .targetCount = 1,
+                                      .targets = &colorTargetState};
+    wgpu::RenderPipelineDescriptor descriptor{
+        .vertex = {.module = shaderModule,
+                   .bufferCount = 1,
+                   .buffers = &vertexBufferLayout},
+        .primitive = {.topology = wgpu::PrimitiveTopology::PointList},
+        .fragment = &fragmentState};
+    renderPipeline_ = device_.CreateRenderPipeline(&descriptor);
+  }
+
+  wgpu::Device device_;
+  uint32_t particleCount_;
+  uint32_t groupsX_ = 1;
+  uint32_t groupsY_ = 1;
+
+  wgpu::Buffer particleBuffers_[2];
+  wgpu::Buffer paramsBuffer_;
+
+  wgpu::ComputePipeline simulatePipeline_;
+  wgpu::BindGroup simulateBindGroups_[2];
+  wgpu::RenderPipeline renderPipeline_;
+};
+
+} // namespace
+
+std::unique_ptr<Scene> CreateParticleScene(const wgpu::Device &device,
+                                           wgpu::TextureFormat format,
+                                           uint32_t particleCount) {
+  return std::make_unique<ParticleScene>(device, format, particleCount);
+}
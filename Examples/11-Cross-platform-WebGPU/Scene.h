@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <webgpu/webgpu_cpp.h>
+
+// A Scene encodes everything needed to draw one frame into an offscreen
+// target. headless.cpp owns the targets, the frame loop and the timing; each
+// scene only records commands.
+
+struct FrameTarget {
+  wgpu::TextureView view;
+  uint32_t width;
+  uint32_t height;
+  uint64_t frameIndex;
+
+  // Null when the device has no timestamp queries. Otherwise the scene writes
+  // `beginQuery` at the start of its first pass and `endQuery` at the end of
+  // its last pass.
+  wgpu::QuerySet querySet;
+  uint32_t beginQuery;
+  uint32_t endQuery;
+};
+
+class Scene {
+public:
+  virtual ~Scene() = default;
+  virtual void Encode(const wgpu::CommandEncoder &encoder,
+                      const FrameTarget &target) = 0;
+};
+
+// Fills `writes` for a pass that is the first and/or last of the frame, and
+// returns it, or nullptr when no timestamps are being recorded. Works for both
+// wgpu::ComputePassTimestampWrites and wgpu::RenderPassTimestampWrites.
+template <typename TimestampWrites>
+const TimestampWrites *PassTimestamps(const FrameTarget &target, bool first,
+                                      bool last, TimestampWrites *writes) {
+  if (!target.querySet || (!first && !last)) {
+    return nullptr;
+  }
+  writes->querySet = target.querySet;
+  writes->beginningOfPassWriteIndex =
+      first ? target.beginQuery : WGPU_QUERY_SET_INDEX_UNDEFINED;
+  writes->endOfPassWriteIndex =
+      last ? target.endQuery : WGPU_QUERY_SET_INDEX_UNDEFINED;
+  return writes;
+}
+
+inline wgpu::ShaderModule CreateShaderModule(const wgpu::Device &device,
+                                             const char *code) {
+  wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
+  wgslDesc.code = code;
+  wgpu::ShaderModuleDescriptor shaderModuleDescriptor{.nextInChain =
+                                                          &wgslDesc};
+  return device.CreateShaderModule(&shaderModuleDescriptor);
+}
+
+// The single red triangle from main.cpp.
+std::unique_ptr<Scene> CreateTriangleScene(const wgpu::Device &device,
+                                           wgpu::TextureFormat format);
+
+// Up to millions of instances with GPU frustum culling and DrawIndirect.
+std::unique_ptr<Scene> CreateInstancedScene(const wgpu::Device &device,
+                                            wgpu::TextureFormat format,
+                                            uint32_t instanceCount);
+
+// Compute-simulated particles drawn straight from the simulation's ping-pong
+// storage buffers, without any host round-trip.
+std::unique_ptr<Scene> CreateParticleScene(const wgpu::Device &device,
+                                           wgpu::TextureFormat format,
+                                           uint32_t particleCount);
@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "Scene.h"
+
+// Headless version of main.cpp. Instead of presenting to a GLFW window it
+// renders into a ring of offscreen textures with several frames in flight, so
+// it runs on machines without a display, on any adapter Dawn exposes
+// (including its CPU adapter).
+//
+// Usage: app-headless [--frames N] [--in-flight K] [--readback]
+//                     [--width W] [--height H]
+//                     [--backend null|vulkan|metal|d3d12|d3d11|opengl|opengles]
+//                     [--cpu] [--scene triangle|instanced|particles]
+//                     [--instances MAX] [--particles MAX]
+//
+// The instanced and particle scenes are run for 1K, 4K, 16K, ... objects up
+// to MAX and print throughput for each count.
+
+wgpu::Instance instance;
+wgpu::Adapter adapter;
+wgpu::Device device;
+
+const wgpu::TextureFormat kFormat = wgpu::TextureFormat::RGBA8Unorm;
+
+struct Options {
+  uint32_t frames = 600;
+  uint32_t warmup = 10;
+  uint32_t inFlight = 3;
+  bool readback = false;
+  uint32_t width = 512;
+  uint32_t height = 512;
+  wgpu::BackendType backendType = wgpu::BackendType::Undefined;
+  bool forceFallbackAdapter = false;
+  std::string scene = "triangle";
+  uint32_t maxInstances = 4 * 1024 * 1024;
+  uint32_t maxParticles = 4 * 1024 * 1024;
+};
+
+wgpu::BackendType ParseBackend(const char *name) {
+  const std::pair<const char *, wgpu::BackendType> backends[] = {
+      {"null", wgpu::BackendType::Null},
+      {"vulkan", wgpu::BackendType::Vulkan},
+      {"metal", wgpu::BackendType::Metal},
+      {"d3d12", wgpu::BackendType::D3D12},
+      {"d3d11", wgpu::BackendType::D3D11},
+      {"opengl", wgpu::BackendType::OpenGL},
+      {"opengles", wgpu::BackendType::OpenGLES},
+  };
+  for (const auto &[backendName, type] : backends) {
+    if (std::strcmp(name, backendName) == 0) {
+      return type;
+    }
+  }
+  std::cout << "Unknown backend: " << name << std::endl;
+  exit(1);
+}
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--readback") == 0) {
+      options.readback = true;
+    } else if (std::strcmp(argv[i], "--cpu") == 0) {
+      options.forceFallbackAdapter = true;
+    } else if (hasValue && std::strcmp(argv[i], "--frames") == 0) {
+      options.frames = std::max(1, std::atoi(argv[++i]));
+    } else if (hasValue && std::strcmp(argv[i], "--in-flight") == 0) {
+      options.inFlight = std::max(1, std::atoi(argv[++i]));
+    } else if (hasValue && std::strcmp(argv[i], "--width") == 0) {
+      options.width = std::atoi(argv[++i]);
+    } else if (hasValue && std::strcmp(argv[i], "--height") == 0) {
+      options.height = std::atoi(argv[++i]);
+    } else if (hasValue && std::strcmp(argv[i], "--scene") == 0) {
+      options.scene = argv[++i];
+    } else if (hasValue && std::strcmp(argv[i], "--instances") == 0) {
+      options.maxInstances = std::atoi(argv[++i]);
+    } else if (hasValue && std::strcmp(argv[i], "--particles") == 0) {
+      options.maxParticles = std::atoi(argv[++i]);
+    } else if (hasValue && std::strcmp(argv[i], "--backend") == 0) {
+      options.backendType = ParseBackend(argv[++i]);
+    } else {
+      std::cout << "Unknown argument: " << argv[i] << std::endl;
+      exit(1);
+    }
+  }
+  return options;
+}
+
+void GetAdapter(const Options &options) {
+  wgpu::RequestAdapterOptions adapterOptions{};
+  adapterOptions.backendType = options.backendType;
+  adapterOptions.forceFallbackAdapter = options.forceFallbackAdapter;
+
+  bool done = false;
+  instance.RequestAdapter(
+      &adapterOptions,
+      [](WGPURequestAdapterStatus status, WGPUAdapter cAdapter,
+         const char *message, void *userdata) {
+        if (message) {
+          printf("RequestAdapter: %s\n", message);
+        }
+        if (status != WGPURequestAdapterStatus_Success) {
+          exit(0);
+        }
+        adapter = wgpu::Adapter::Acquire(cAdapter);
+        *reinterpret_cast<bool *>(userdata) = true;
+      },
+      reinterpret_cast<void *>(&done));
+  while (!done) {
+    instance.ProcessEvents();
+  }
+}
+
+void GetDevice() {
+  // Timestamps are optional: without them only CPU-side timings are shown.
+  std::vector<wgpu::FeatureName> requiredFeatures;
+  if (adapter.HasFeature(wgpu::FeatureName::TimestampQuery)) {
+    requiredFeatures.push_back(wgpu::FeatureName::TimestampQuery);
+  }
+  const char *enabledToggles[] = {"allow_unsafe_apis"};
+  wgpu::DawnTogglesDescriptor toggles{};
+  toggles.enabledToggleCount = 1;
+  toggles.enabledToggles = enabledToggles;
+
+  wgpu::DeviceDescriptor deviceDescriptor{};
+  deviceDescriptor.nextInChain = &toggles;
+  deviceDescriptor.requiredFeatures = requiredFeatures.data();
+  deviceDescriptor.requiredFeatureCount = requiredFeatures.size();
+
+  bool done = false;
+  adapter.RequestDevice(
+      &deviceDescriptor,
+      [](WGPURequestDeviceStatus status, WGPUDevice cDevice,
+         const char *message, void *userdata) {
+        if (message) {
+          printf("RequestDevice: %s\n", message);
+        }
+        if (status != WGPURequestDeviceStatus_Success) {
+          exit(0);
+        }
+        device = wgpu::Device::Acquire(cDevice);
+        device.SetUncapturedErrorCallback(
+            [](WGPUErrorType type, const char *message, void *userdata) {
+              std::cout << "Error: " << type << " - message: " << message;
+            },
+            nullptr);
+        *reinterpret_cast<bool *>(userdata) = true;
+      },
+      reinterpret_cast<void *>(&done));
+  while (!done) {
+    instance.ProcessEvents();
+  }
+}
+
+// Triangle scene
+
+const char shaderCode[] = R"(
+    @vertex fn vertexMain(@builtin(vertex_index) i : u32) ->
+      @builtin(position) vec4f {
+        const pos = array(vec2f(0, 1), vec2f(-1, -1), vec2f(1, -1));
+        return vec4f(pos[i], 0, 1);
+    }
+    @fragment fn fragmentMain() -> @location(0) vec4f {
+        return vec4f(1, 0, 0, 1);
+    }
+)";
+
+class TriangleScene : public Scene {
+public:
+  TriangleScene(const wgpu::Device &device, wgpu::TextureFormat format) {
+    wgpu::ShaderModule shaderModule = CreateShaderModule(device, shaderCode);
+
+    wgpu::ColorTargetState colorTargetState{.format = format};
+    wgpu::FragmentState fragmentState{.module = shaderModule,
+                                      .targetCount = 1,
+                                      .targets = &colorTargetState};
+    wgpu::RenderPipelineDescriptor descriptor{
+        .vertex = {.module = shaderModule}, .fragment = &fragmentState};
+    pipeline_ = device.CreateRenderPipeline(&descriptor);
+  }
+
+  void Encode(const wgpu::CommandEncoder &encoder,
+              const FrameTarget &target) override {
+    wgpu::RenderPassColorAttachment attachment{
+        .view = target.view,
+        .loadOp = wgpu::LoadOp::Clear,
+        .storeOp = wgpu::StoreOp::Store};
+    wgpu::RenderPassTimestampWrites timestamps{};
+    wgpu::RenderPassDescriptor renderpass{
+        .colorAttachmentCount = 1,
+        .colorAttachments = &attachment,
+        .timestampWrites = PassTimestamps(target, true, true, &timestamps)};
+
+    wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&renderpass);
+    pass.SetPipeline(pipeline_);
+    pass.Draw(3);
+    pass.End();
+  }
+
+private:
+  wgpu::RenderPipeline pipeline_;
+};
+
+std::unique_ptr<Scene> CreateTriangleScene(const wgpu::Device &device,
+                                           wgpu::TextureFormat format) {
+  return std::make_unique<TriangleScene>(device, format);
+}
+
+// Offscreen frame ring
+
+struct FrameSlot {
+  wgpu::Texture texture;
+  wgpu::TextureView view;
+
+  // Pipelined readback: the copy is recorded in the frame's own command
+  // buffer and mapped asynchronously; the slot is not reused until then.
+  wgpu::Buffer readBuffer;
+
+  wgpu::Buffer queryResolveBuffer;
+  wgpu::Buffer queryReadBuffer;
+
+  // Outstanding asynchronous operations (work done, maps) for this slot.
+  int pending = 0;
+};
+
+struct FrameStats {
+  uint64_t gpuNs = 0;
+  uint64_t gpuFrames = 0;
+  uint64_t bytesRead = 0;
+};
+
+FrameStats stats;
+uint32_t readBytesPerRow = 0;
+bool timestamps = false;
+
+void OnWorkDone(WGPUQueueWorkDoneStatus status, void *userdata) {
+  --reinterpret_cast<FrameSlot *>(userdata)->pending;
+}
+
+void OnFrameMapped(WGPUBufferMapAsyncStatus status, void *userdata) {
+  FrameSlot *slot = reinterpret_cast<FrameSlot *>(userdata);
+  if (status == WGPUBufferMapAsyncStatus_Success) {
+    stats.bytesRead += slot->readBuffer.GetSize();
+    slot->readBuffer.Unmap();
+  } else {
+    std::cout << "Failed to map frame buffer" << std::endl;
+  }
+  --slot->pending;
+}
+
+void OnQueriesMapped(WGPUBufferMapAsyncStatus status, void *userdata) {
+  FrameSlot *slot = reinterpret_cast<FrameSlot *>(userdata);
+  if (status == WGPUBufferMapAsyncStatus_Success) {
+    const uint64_t *ticks = static_cast<const uint64_t *>(
+        slot->queryReadBuffer.GetConstMappedRange(0, 2 * sizeof(uint64_t)));
+    // Timestamps may be reset between passes on some drivers; ignore those.
+    if (ticks[1] > ticks[0]) {
+      stats.gpuNs += ticks[1] - ticks[0];
+      ++stats.gpuFrames;
+    }
+    slot->queryReadBuffer.Unmap();
+  }
+  --slot->pending;
+}
+
+std::vector<FrameSlot> CreateFrameRing(const Options &options) {
+  std::vector<FrameSlot> ring(options.inFlight);
+  readBytesPerRow = (options.width * 4 + 255) / 256 * 256;
+
+  for (FrameSlot &slot : ring) {
+    wgpu::TextureDescriptor textureDesc{
+        .usage = wgpu::TextureUsage::RenderAttachment |
+                 wgpu::TextureUsage::CopySrc,
+        .size = {options.width, options.height, 1},
+        .format = kFormat};
+    slot.texture = device.CreateTexture(&textureDesc);
+    slot.view = slot.texture.CreateView();
+
+    if (options.readback) {
+      wgpu::BufferDescriptor readDesc{
+          .usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead,
+          .size = uint64_t(readBytesPerRow) * options.height};
+      slot.readBuffer = device.CreateBuffer(&readDesc);
+    }
+
+    if (timestamps) {
+      wgpu::BufferDescriptor resolveDesc{
+          .usage =
+              wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc,
+          .size = 2 * sizeof(uint64_t)};
+      slot.queryResolveBuffer = device.CreateBuffer(&resolveDesc);
+      wgpu::BufferDescriptor queryReadDesc{
+          .usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead,
+          .size = 2 * sizeof(uint64_t)};
+      slot.queryReadBuffer = device.CreateBuffer(&queryReadDesc);
+    }
+  }
+  return ring;
+}
+
+void WaitForSlot(const FrameSlot &slot) {
+  while (slot.pending > 0) {
+    instance.ProcessEvents();
+  }
+}
+
+void RenderFrame(Scene &scene, FrameSlot &slot, uint32_t slotIndex,
+                 uint64_t frameIndex, const wgpu::QuerySet &querySet,
+                 const Options &options) {
+  wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+
+  FrameTarget target{.view = slot.view,
+                     .width = options.width,
+                     .height = options.height,
+                     .frameIndex = frameIndex,
+                     .querySet = querySet,
+                     .beginQuery = 2 * slotIndex,
+                     .endQuery = 2 * slotIndex + 1};
+  scene.Encode(encoder, target);
+
+  if (options.readback) {
+    wgpu::ImageCopyTexture source{.texture = slot.texture};
+    wgpu::ImageCopyBuffer destination{
+        .layout = {.bytesPerRow = readBytesPerRow,
+                   .rowsPerImage = options.height},
+        .buffer = slot.readBuffer};
+    wgpu::Extent3D copySize{options.width, options.height, 1};
+    encoder.CopyTextureToBuffer(&source, &destination, &copySize);
+  }
+
+  if (querySet) {
+    encoder.ResolveQuerySet(querySet, 2 * slotIndex, 2,
+                            slot.queryResolveBuffer, 0);
+    encoder.CopyBufferToBuffer(slot.queryResolveBuffer, 0,
+                               slot.queryReadBuffer, 0, 2 * sizeof(uint64_t));
+  }
+
+  wgpu::CommandBuffer commands = encoder.Finish();
+  device.GetQueue().Submit(1, &commands);
+
+  ++slot.pending;
+  device.GetQueue().OnSubmittedWorkDone(OnWorkDone,
+                                        reinterpret_cast<void *>(&slot));
+  if (options.readback) {
+    ++slot.pending;
+    slot.readBuffer.MapAsync(wgpu::MapMode::Read, 0,
+                             slot.readBuffer.GetSize(), OnFrameMapped,
+                             reinterpret_cast<void *>(&slot));
+  }
+  if (querySet) {
+    ++slot.pending;
+    slot.queryReadBuffer.MapAsync(wgpu::MapMode::Read, 0,
+                                  2 * sizeof(uint64_t), OnQueriesMapped,
+                                  reinterpret_cast<void *>(&slot));
+  }
+}
+
+void PrintAdapter() {
+  wgpu::AdapterProperties properties{};
+  adapter.GetProperties(&properties);
+  std::cout << "Adapter: " << properties.name << " ("
+            << properties.driverDescription << ")" << std::endl;
+}
+
+struct RunResult {
+  double framesPerSecond;
+  double encodeUs;
+  double gpuUs; // negative without timestamp queries
+  double readbackMBps;
+};
+
+RunResult RunHeadless(Scene &scene, const Options &options) {
+  wgpu::QuerySet querySet;
+  if (timestamps) {
+    wgpu::QuerySetDescriptor querySetDesc{.type = wgpu::QueryType::Timestamp,
+                                          .count = 2 * options.inFlight};
+    querySet = device.CreateQuerySet(&querySetDesc);
+  }
+
+  std::vector<FrameSlot> ring = CreateFrameRing(options);
+
+  for (uint32_t i = 0; i < options.warmup; ++i) {
+    const uint32_t slotIndex = i % options.inFlight;
+    WaitForSlot(ring[slotIndex]);
+    RenderFrame(scene, ring[slotIndex], slotIndex, i, querySet, options);
+  }
+  for (const FrameSlot &slot : ring) {
+    WaitForSlot(slot);
+  }
+  stats = {};
+
+  double encodeSeconds = 0.0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < options.frames; ++i) {
+    const uint32_t slotIndex = i % options.inFlight;
+    WaitForSlot(ring[slotIndex]);
+
+    const auto encodeStart = std::chrono::steady_clock::now();
+    RenderFrame(scene, ring[slotIndex], slotIndex, options.warmup + i,
+                querySet, options);
+    encodeSeconds += std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - encodeStart)
+                         .count();
+  }
+  for (const FrameSlot &slot : ring) {
+    WaitForSlot(slot);
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  return RunResult{
+      .framesPerSecond = options.frames / seconds,
+      .encodeUs = encodeSeconds / options.frames * 1e6,
+      .gpuUs = stats.gpuFrames > 0
+                   ? double(stats.gpuNs) / stats.gpuFrames * 1e-3
+                   : -1.0,
+      .readbackMBps = stats.bytesRead / seconds * 1e-6};
+}
+
+void PrintResult(const RunResult &result, const Options &options) {
+  std::cout << "Frames: " << options.frames << " at " << options.width << "x"
+            << options.height << ", " << options.inFlight << " in flight"
+            << (options.readback ? ", with readback" : "") << std::endl;
+  std::cout << "Frames/second: " << result.framesPerSecond << std::endl;
+  std::cout << "CPU encode+submit per frame: " << result.encodeUs << " us"
+            << std::endl;
+  if (result.gpuUs >= 0.0) {
+    std::cout << "GPU time per frame: " << result.gpuUs << " us" << std::endl;
+  } else {
+    std::cout << "GPU time per frame: n/a (no timestamp queries)"
+              << std::endl;
+  }
+  if (options.readback) {
+    std::cout << "Readback: " << result.readbackMBps << " MB/s" << std::endl;
+  }
+}
+
+// Throughput of a scene as its object count grows.
+void RunSweep(const Options &options, const char *objects, uint32_t maxCount,
+              std::unique_ptr<Scene> (*createScene)(const wgpu::Device &,
+                                                    wgpu::TextureFormat,
+                                                    uint32_t)) {
+  std::cout << objects << "  frames/s  M" << objects
+            << "/s  encode us  GPU us" << std::endl;
+  // 64-bit so that stepping past a maxCount near UINT32_MAX ends the loop.
+  for (uint64_t count = 1024; count <= maxCount; count *= 4) {
+    std::unique_ptr<Scene> scene =
+        createScene(device, kFormat, uint32_t(count));
+    const RunResult result = RunHeadless(*scene, options);
+    std::cout << count << "\t   " << result.framesPerSecond << "\t     "
+              << result.framesPerSecond * count * 1e-6 << "\t   "
+              << result.encodeUs << "\t" << result.gpuUs << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  const Options options = ParseOptions(argc, argv);
+
+  instance = wgpu::CreateInstance();
+  GetAdapter(options);
+  PrintAdapter();
+  GetDevice();
+  timestamps = device.HasFeature(wgpu::FeatureName::TimestampQuery);
+
+  if (options.scene == "instanced") {
+    RunSweep(options, "instances", options.maxInstances,
+             CreateInstancedScene);
+  } else if (options.scene == "particles") {
+    RunSweep(options, "particles", options.maxParticles, CreateParticleScene);
+  } else if (options.scene == "triangle") {
+    std::unique_ptr<Scene> scene = CreateTriangleScene(device, kFormat);
+    PrintResult(RunHeadless(*scene, options), options);
+  } else {
+    std::cout << "Unknown scene: " << options.scene << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include "BindGroupCache.h"
+
+#include <algorithm>
+
+BindGroupCache::BindGroupCache(wgpu::Device device, size_t capacity)
+    : device_(std::move(device)), capacity_(capacity) {}
+
+wgpu::BindGroup BindGroupCache::Get(const wgpu::BindGroupLayout &layout,
+                                    const wgpu::BindGroupEntry *entries,
+                                    size_t entryCount) {
+  wgpu::BindGroupDescriptor bindGroupDesc = {};
+  bindGroupDesc.layout = layout;
+  bindGroupDesc.entryCount = entryCount;
+  bindGroupDesc.entries = entries;
+  if (capacity_ == 0) {
+    ++stats_.misses;
+    return device_.CreateBindGroup(&bindGroupDesc);
+  }
+
+  Key key{layout.Get(), {}};
+  key.second.reserve(entryCount);
+  for (size_t i = 0; i < entryCount; ++i) {
+    key.second.emplace_back(entries[i].binding, entries[i].buffer.Get(),
+                            entries[i].offset, entries[i].size);
+  }
+  // The order of the entries does not matter to CreateBindGroup.
+  std::sort(key.second.begin(), key.second.end());
+
+  auto found = bindGroups_.find(key);
+  if (found != bindGroups_.end()) {
+    ++stats_.hits;
+    uses_.splice(uses_.begin(), uses_, found->second.use);
+    return found->second.bindGroup;
+  }
+
+  ++stats_.misses;
+  if (bindGroups_.size() == capacity_) {
+    ++stats_.evictions;
+    bindGroups_.erase(uses_.back());
+    uses_.pop_back();
+  }
+  uses_.push_front(key);
+  wgpu::BindGroup bindGroup = device_.CreateBindGroup(&bindGroupDesc);
+  bindGroups_.emplace(std::move(key), Cached{bindGroup, uses_.begin()});
+  return bindGroup;
+}
+
+void BindGroupCache::Forget(const wgpu::Buffer &buffer) {
+  const void *handle = buffer.Get();
+  for (auto it = bindGroups_.begin(); it != bindGroups_.end();) {
+    const std::vector<EntryKey> &entries = it->first.second;
+    const bool references =
+        std::any_of(entries.begin(), entries.end(), [&](const EntryKey &entry) {
+          return std::get<1>(entry) == handle;
+        });
+    if (references) {
+      uses_.erase(it->second.use);
+      it = bindGroups_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void BindGroupCache::Clear() {
+  bindGroups_.clear();
+  uses_.clear();
+}
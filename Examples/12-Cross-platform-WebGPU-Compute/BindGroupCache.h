@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+// Reuses bind groups across identical requests. A request is identified by
+// its layout and, for every entry, the (binding, buffer, offset, size)
+// tuple, so code that binds the same ranges on every dispatch creates each
+// bind group once.
+//
+// Handles are compared by address. That is safe because a cached bind group
+// holds references to its layout and buffers, so none of them can be freed
+// and its address reused while the entry exists. It also means the cache
+// keeps those buffers alive: it holds at most `capacity` bind groups and
+// drops the least recently used one beyond that, and Forget() drops the
+// ones that reference a given buffer. A capacity of 0 disables caching.
+//
+// Only buffer entries are supported. Not thread-safe.
+class BindGroupCache {
+public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+  };
+
+  explicit BindGroupCache(wgpu::Device device, size_t capacity = 32);
+
+  wgpu::BindGroup Get(const wgpu::BindGroupLayout &layout,
+                      const wgpu::BindGroupEntry *entries, size_t entryCount);
+
+  // Drops every cached bind group that references `buffer`.
+  void Forget(const wgpu::Buffer &buffer);
+  void Clear();
+
+  size_t GetSize() const { return bindGroups_.size(); }
+  Stats GetStats() const { return stats_; }
+
+private:
+  using EntryKey = std::tuple<uint32_t, const void *, uint64_t, uint64_t>;
+  using Key = std::pair<const void *, std::vector<EntryKey>>;
+
+  struct Cached {
+    wgpu::BindGroup bindGroup;
+    std::list<Key>::iterator use;
+  };
+
+  wgpu::Device device_;
+  size_t capacity_;
+  std::map<Key, Cached> bindGroups_;
+  // Most recently used first.
+  std::list<Key> uses_;
+  Stats stats_;
+};
@@ -0,0 +1,113 @@
+#include "BufferPlanner.h"
+
+#include <algorithm>
+#include <numeric>
+
+PlannedBufferId BufferPlanner::AddBuffer(uint64_t size, bool aliasable) {
+  buffers_.push_back(Buffer{.size = size, .aliasable = aliasable});
+  return PlannedBufferId(buffers_.size() - 1);
+}
+
+void BufferPlanner::AddOp(const std::vector<PlannedBufferId> &buffers) {
+  for (PlannedBufferId id : buffers) {
+    Buffer &buffer = buffers_[id];
+    if (buffer.firstOp < 0) {
+      buffer.firstOp = opCount_;
+    }
+    buffer.lastOp = opCount_;
+  }
+  ++opCount_;
+}
+
+BufferPlan BufferPlanner::Plan(bool alias) const {
+  BufferPlan plan;
+  plan.assignments.resize(buffers_.size());
+
+  auto newAllocation = [&plan](PlannedBufferId id, uint64_t size,
+                               bool aliased) {
+    plan.allocationSizes.push_back(size);
+    plan.allocationAliased.push_back(aliased);
+    plan.assignments[id] = {
+        .allocation = uint32_t(plan.allocationSizes.size() - 1),
+        .size = size};
+  };
+
+  std::vector<PlannedBufferId> aliasable;
+  for (PlannedBufferId id = 0; id < buffers_.size(); ++id) {
+    plan.naiveBytes += buffers_[id].size;
+    // Unused buffers have no lifetime to share.
+    if (alias && buffers_[id].aliasable && buffers_[id].firstOp >= 0) {
+      aliasable.push_back(id);
+    } else {
+      newAllocation(id, buffers_[id].size, false);
+    }
+  }
+
+  // Largest first, so every allocation is sized by the first buffer placed
+  // in it and later (smaller) buffers never need to grow it.
+  std::stable_sort(aliasable.begin(), aliasable.end(),
+                   [this](PlannedBufferId a, PlannedBufferId b) {
+                     return buffers_[a].size > buffers_[b].size;
+                   });
+
+  // Buffers placed in each aliased allocation so far.
+  std::vector<std::vector<PlannedBufferId>> occupants(
+      plan.allocationSizes.size());
+  auto overlaps = [this](PlannedBufferId a, PlannedBufferId b) {
+    return buffers_[a].firstOp <= buffers_[b].lastOp &&
+           buffers_[b].firstOp <= buffers_[a].lastOp;
+  };
+
+  for (PlannedBufferId id : aliasable) {
+    int64_t best = -1;
+    for (size_t allocation = 0; allocation < occupants.size(); ++allocation) {
+      if (!plan.allocationAliased[allocation] ||
+          plan.allocationSizes[allocation] < buffers_[id].size) {
+        continue;
+      }
+      const bool free = std::none_of(
+          occupants[allocation].begin(), occupants[allocation].end(),
+          [&](PlannedBufferId other) { return overlaps(id, other); });
+      if (free && (best < 0 || plan.allocationSizes[allocation] <
+                                   plan.allocationSizes[best])) {
+        best = int64_t(allocation);
+      }
+    }
+
+    if (best < 0) {
+      newAllocation(id, buffers_[id].size, true);
+      occupants.push_back({id});
+    } else {
+      plan.assignments[id] = {.allocation = uint32_t(best),
+                              .size = buffers_[id].size};
+      occupants[best].push_back(id);
+    }
+  }
+
+  plan.plannedBytes = std::accumulate(plan.allocationSizes.begin(),
+                                      plan.allocationSizes.end(), uint64_t(0));
+  return plan;
+}
+
+PlannedBuffers::PlannedBuffers(TrackedAllocator &allocator,
+                               const BufferPlan &plan, wgpu::BufferUsage usage)
+    : assignments_(plan.assignments) {
+  allocations_.reserve(plan.allocationSizes.size());
+  for (size_t i = 0; i < plan.allocationSizes.size(); ++i) {
+    wgpu::BufferDescriptor descriptor{
+        .usage = usage,
+        .size = plan.allocationSizes[i],
+    };
+    allocations_.push_back(
+        plan.allocationAliased[i]
+            ? allocator.CreateBuffer(descriptor, BufferCategory::Intermediate)
+            : allocator.CreateBuffer(descriptor));
+  }
+}
+
+BufferBinding PlannedBuffers::Binding(PlannedBufferId id) const {
+  const BufferPlan::Assignment &assignment = assignments_[id];
+  return BufferBinding{.buffer = allocations_[assignment.allocation].Get(),
+                       .offset = 0,
+                       .size = assignment.size};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmPipeline.h"
+#include "TrackedAllocator.h"
+
+// Liveness-based buffer aliasing for a fixed sequence of operations.
+//
+// Declare every logical buffer of a workload, then the operations in the
+// order they will be recorded, each with the buffers it touches. A buffer is
+// live from the first to the last operation that uses it. Plan() assigns
+// aliasable buffers whose lifetimes do not overlap to the same allocation
+// (greedy by size, best fit), so a chain of intermediates only needs as many
+// allocations as are live at the same time. Buffers used by the same
+// operation never share an allocation.
+
+using PlannedBufferId = uint32_t;
+
+struct BufferPlan {
+  struct Assignment {
+    uint32_t allocation;
+    uint64_t size;
+  };
+
+  std::vector<uint64_t> allocationSizes;
+  std::vector<bool> allocationAliased;
+  std::vector<Assignment> assignments; // indexed by PlannedBufferId
+
+  uint64_t naiveBytes = 0;   // one allocation per logical buffer
+  uint64_t plannedBytes = 0; // sum of allocationSizes
+};
+
+class BufferPlanner {
+public:
+  // Aliasable buffers are intermediates whose contents only matter between
+  // their first and last use. Inputs and outputs must not be aliasable.
+  PlannedBufferId AddBuffer(uint64_t size, bool aliasable);
+
+  void AddOp(const std::vector<PlannedBufferId> &buffers);
+
+  // With `alias` false every buffer gets its own allocation, which is
+  // convenient for comparing against the planned layout.
+  BufferPlan Plan(bool alias = true) const;
+
+private:
+  struct Buffer {
+    uint64_t size;
+    bool aliasable;
+    int64_t firstOp = -1;
+    int64_t lastOp = -1;
+  };
+
+  std::vector<Buffer> buffers_;
+  int64_t opCount_ = 0;
+};
+
+// The allocations of a BufferPlan. Aliased allocations are accounted as
+// BufferCategory::Intermediate, the others by their usage.
+class PlannedBuffers {
+public:
+  PlannedBuffers(TrackedAllocator &allocator, const BufferPlan &plan,
+                 wgpu::BufferUsage usage);
+
+  BufferBinding Binding(PlannedBufferId id) const;
+
+private:
+  std::vector<TrackedBuffer> allocations_;
+  std::vector<BufferPlan::Assignment> assignments_;
+};
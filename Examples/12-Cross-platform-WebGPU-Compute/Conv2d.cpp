@@ -0,0 +1,281 @@
+#include "Conv2d.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "DeviceHelpers.h"
+#include "GemmKernel.h"
+
+namespace {
+
+// Host-side mirror of the ConvParams uniform.
+struct ConvParams {
+  uint32_t m;
+  uint32_t n;
+  uint32_t k;
+  uint32_t batch;
+  uint32_t inChannels;
+  uint32_t inHeight;
+  uint32_t inWidth;
+  uint32_t outChannels;
+  uint32_t outHeight;
+  uint32_t outWidth;
+  uint32_t kernelHeight;
+  uint32_t kernelWidth;
+  uint32_t strideHeight;
+  uint32_t strideWidth;
+  uint32_t padHeight;
+  uint32_t padWidth;
+  uint32_t dilationHeight;
+  uint32_t dilationWidth;
+  uint32_t pad[2];
+};
+
+const char convParamsDeclaration[] = R"(
+    struct ConvParams {
+        M : u32,
+        N : u32,
+        K : u32,
+        batch : u32,
+        inC : u32,
+        inH : u32,
+        inW : u32,
+        outC : u32,
+        outH : u32,
+        outW : u32,
+        kH : u32,
+        kW : u32,
+        strideH : u32,
+        strideW : u32,
+        padH : u32,
+        padW : u32,
+        dilH : u32,
+        dilW : u32,
+    };
+
+    @group(0) @binding(3) var<uniform> params : ConvParams;
+)";
+
+// Element (row, col) of the virtual M x K patch matrix.
+std::string GatherInputFunction(TensorLayout layout) {
+  const bool nchw = layout == TensorLayout::NCHW;
+  return std::string(R"(
+    fn gatherInput(row : u32, col : u32) -> f32 {
+        if (row >= params.M || col >= params.K) {
+            return 0.0;
+        }
+        let ow = row % params.outW;
+        let oh = (row / params.outW) % params.outH;
+        let n = row / (params.outW * params.outH);
+)") + (nchw ? R"(
+        // col = (c * kH + r) * kW + s
+        let s = col % params.kW;
+        let r = (col / params.kW) % params.kH;
+        let c = col / (params.kW * params.kH);
+)"
+            : R"(
+        // col = (r * kW + s) * inC + c
+        let c = col % params.inC;
+        let s = (col / params.inC) % params.kW;
+        let r = col / (params.inC * params.kW);
+)") + R"(
+        let ih = i32(oh * params.strideH + r * params.dilH) - i32(params.padH);
+        let iw = i32(ow * params.strideW + s * params.dilW) - i32(params.padW);
+        if (ih < 0 || iw < 0 || ih >= i32(params.inH) || iw >= i32(params.inW)) {
+            return 0.0;
+        }
+)" + (nchw ? R"(
+        return inputTensor[((n * params.inC + c) * params.inH + u32(ih)) * params.inW + u32(iw)];
+    }
+)"
+           : R"(
+        return inputTensor[((n * params.inH + u32(ih)) * params.inW + u32(iw)) * params.inC + c];
+    }
+)");
+}
+
+std::string LoadWeightsFunction(TensorLayout layout) {
+  return std::string(R"(
+    fn loadB(row : u32, col : u32) -> f32 {
+        if (row >= params.K || col >= params.N) {
+            return 0.0;
+        }
+)") + (layout == TensorLayout::NCHW
+                  ? "        return weights[col * params.K + row];\n"
+                  : "        return weights[row * params.N + col];\n") +
+         "    }\n";
+}
+
+std::string StoreOutputFunction(TensorLayout layout) {
+  if (layout == TensorLayout::NHWC) {
+    return R"(
+    fn storeC(row : u32, col : u32, value : f32) {
+        outputTensor[row * params.N + col] = value;
+    }
+)";
+  }
+  return R"(
+    fn storeC(row : u32, col : u32, value : f32) {
+        let pixels = params.outH * params.outW;
+        let n = row / pixels;
+        let pixel = row % pixels;
+        outputTensor[(n * params.outC + col) * pixels + pixel] = value;
+    }
+)";
+}
+
+} // namespace
+
+Conv2d::Conv2d(const wgpu::Device &device, TrackedAllocator &allocator,
+               TensorLayout layout, const Conv2dShape &shape,
+               ConvAlgorithm algorithm)
+    : device_(device), shape_(shape), algorithm_(algorithm) {
+  if (shape.strideHeight == 0 || shape.strideWidth == 0 ||
+      shape.dilationHeight == 0 || shape.dilationWidth == 0 ||
+      shape.kernelHeight == 0 || shape.kernelWidth == 0) {
+    throw std::invalid_argument(
+        "Conv2d: kernel size, stride and dilation must be non-zero");
+  }
+  // OutHeight()/OutWidth() would underflow otherwise.
+  if (uint64_t(shape.dilationHeight) * (shape.kernelHeight - 1) + 1 >
+          uint64_t(shape.inHeight) + 2 * uint64_t(shape.padHeight) ||
+      uint64_t(shape.dilationWidth) * (shape.kernelWidth - 1) + 1 >
+          uint64_t(shape.inWidth) + 2 * uint64_t(shape.padWidth)) {
+    throw std::invalid_argument(
+        "Conv2d: dilated kernel is larger than the padded input");
+  }
+  if (shape.GemmM() > UINT32_MAX || shape.GemmK() > UINT32_MAX) {
+    throw std::invalid_argument("Conv2d: problem too large");
+  }
+
+  const ConvParams params{
+      .m = uint32_t(shape.GemmM()),
+      .n = uint32_t(shape.GemmN()),
+      .k = uint32_t(shape.GemmK()),
+      .batch = shape.batch,
+      .inChannels = shape.inChannels,
+      .inHeight = shape.inHeight,
+      .inWidth = shape.inWidth,
+      .outChannels = shape.outChannels,
+      .outHeight = shape.OutHeight(),
+      .outWidth = shape.OutWidth(),
+      .kernelHeight = shape.kernelHeight,
+      .kernelWidth = shape.kernelWidth,
+      .strideHeight = shape.strideHeight,
+      .strideWidth = shape.strideWidth,
+      .padHeight = shape.padHeight,
+      .padWidth = shape.padWidth,
+      .dilationHeight = shape.dilationHeight,
+      .dilationWidth = shape.dilationWidth,
+  };
+  wgpu::BufferDescriptor paramsDesc{
+      .usage = wgpu::BufferUsage::Uniform,
+      .size = sizeof(params),
+      .mappedAtCreation = true,
+  };
+  paramsBuffer_ = allocator.CreateBuffer(paramsDesc);
+  std::memcpy(paramsBuffer_.Get().GetMappedRange(), &params, sizeof(params));
+  paramsBuffer_.Get().Unmap();
+
+  const std::string weightsDeclaration = R"(
+    @group(0) @binding(1) var<storage, read> weights : array<f32>;
+    @group(0) @binding(2) var<storage, read_write> outputTensor : array<f32>;
+)";
+
+  if (algorithm == ConvAlgorithm::ImplicitGemm) {
+    gemmPipeline_ = CreatePipeline(
+        device_,
+        MakeGemmShader(GemmShaderSource{
+            .declarations = std::string(convParamsDeclaration) + R"(
+    @group(0) @binding(0) var<storage, read> inputTensor : array<f32>;
+)" + weightsDeclaration + GatherInputFunction(layout),
+            .loadA = R"(
+    fn loadA(row : u32, col : u32) -> f32 {
+        return gatherInput(row, col);
+    }
+)",
+            .loadB = LoadWeightsFunction(layout),
+            .storeC = StoreOutputFunction(layout),
+        }));
+    return;
+  }
+
+  if (shape.GemmM() * shape.GemmK() > UINT32_MAX) {
+    throw std::invalid_argument("Conv2d: patch matrix too large for im2col");
+  }
+  wgpu::BufferDescriptor columnsDesc{
+      .usage = wgpu::BufferUsage::Storage,
+      .size = shape.GemmM() * shape.GemmK() * sizeof(float),
+  };
+  columns_ = allocator.CreateBuffer(columnsDesc, BufferCategory::Intermediate);
+
+  im2colPipeline_ = CreatePipeline(
+      device_, std::string(convParamsDeclaration) + R"(
+    @group(0) @binding(0) var<storage, read> inputTensor : array<f32>;
+    @group(0) @binding(2) var<storage, read_write> columns : array<f32>;
+)" + GatherInputFunction(layout) + R"(
+    @compute @workgroup_size(256)
+    fn main(@builtin(global_invocation_id) globalId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>) {
+        let i = globalId.x + globalId.y * groups.x * 256u;
+        if (i >= params.M * params.K) {
+            return;
+        }
+        columns[i] = gatherInput(i / params.K, i % params.K);
+    }
+)");
+
+  gemmPipeline_ = CreatePipeline(
+      device_, MakeGemmShader(GemmShaderSource{
+                   .declarations = std::string(convParamsDeclaration) + R"(
+    @group(0) @binding(0) var<storage, read> columns : array<f32>;
+)" + weightsDeclaration,
+                   .loadA = R"(
+    fn loadA(row : u32, col : u32) -> f32 {
+        if (row >= params.M || col >= params.K) {
+            return 0.0;
+        }
+        return columns[row * params.K + col];
+    }
+)",
+                   .loadB = LoadWeightsFunction(layout),
+                   .storeC = StoreOutputFunction(layout),
+               }));
+}
+
+void Conv2d::Encode(const wgpu::CommandEncoder &encoder,
+                    const BufferBinding &input, const BufferBinding &weights,
+                    const BufferBinding &output) {
+  const BufferBinding params{.buffer = paramsBuffer_.Get()};
+
+  wgpu::ComputePassEncoder passEncoder = encoder.BeginComputePass();
+
+  BufferBinding gemmInput = input;
+  if (algorithm_ == ConvAlgorithm::Im2colGemm) {
+    const BufferBinding columns{.buffer = columns_.Get()};
+    const wgpu::BindGroupEntry entries[3] = {BindingEntry(0, input),
+                                             BindingEntry(2, columns),
+                                             BindingEntry(3, params)};
+    wgpu::BindGroup bindGroup =
+        MakeBindGroup(device_, im2colPipeline_, entries, 3);
+
+    passEncoder.SetPipeline(im2colPipeline_);
+    passEncoder.SetBindGroup(0, bindGroup);
+    DispatchLinear(passEncoder, (shape_.GemmM() * shape_.GemmK() + 255) / 256);
+    gemmInput = columns;
+  }
+
+  const wgpu::BindGroupEntry entries[4] = {
+      BindingEntry(0, gemmInput), BindingEntry(1, weights),
+      BindingEntry(2, output), BindingEntry(3, params)};
+  wgpu::BindGroup bindGroup =
+      MakeBindGroup(device_, gemmPipeline_, entries, 4);
+  passEncoder.SetPipeline(gemmPipeline_);
+  passEncoder.SetBindGroup(0, bindGroup);
+  passEncoder.DispatchWorkgroups(
+      uint32_t((shape_.GemmN() + kGemmTileN - 1) / kGemmTileN),
+      uint32_t((shape_.GemmM() + kGemmTileM - 1) / kGemmTileM));
+  passEncoder.End();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmPipeline.h"
+#include "TrackedAllocator.h"
+
+// 2D convolution as a GEMM: M = batch * outHeight * outWidth output pixels,
+// N = outChannels, K = inChannels * kernelHeight * kernelWidth.
+//
+// ImplicitGemm runs the tiled GEMM kernel from GemmKernel.h with a loadA that
+// gathers input patches straight into the kernel's workgroup tiles, so the
+// patch matrix never exists in memory. Im2colGemm is the explicit baseline:
+// one pass writes the full M x K patch matrix, then the same GEMM kernel
+// reads it.
+//
+// Layouts:
+//   NCHW: input N x C x H x W, weights K x C x R x S (OIHW), output NCHW.
+//   NHWC: input N x H x W x C, weights R x S x C x K (HWIO), output NHWC.
+
+enum class TensorLayout { NCHW, NHWC };
+
+enum class ConvAlgorithm { ImplicitGemm, Im2colGemm };
+
+struct Conv2dShape {
+  uint32_t batch = 1;
+  uint32_t inChannels = 1;
+  uint32_t inHeight = 1;
+  uint32_t inWidth = 1;
+  uint32_t outChannels = 1;
+  uint32_t kernelHeight = 1;
+  uint32_t kernelWidth = 1;
+  uint32_t strideHeight = 1;
+  uint32_t strideWidth = 1;
+  uint32_t padHeight = 0;
+  uint32_t padWidth = 0;
+  uint32_t dilationHeight = 1;
+  uint32_t dilationWidth = 1;
+
+  uint32_t OutHeight() const {
+    return (inHeight + 2 * padHeight - dilationHeight * (kernelHeight - 1) -
+            1) / strideHeight + 1;
+  }
+  uint32_t OutWidth() const {
+    return (inWidth + 2 * padWidth - dilationWidth * (kernelWidth - 1) - 1) /
+               strideWidth + 1;
+  }
+
+  uint64_t GemmM() const { return uint64_t(batch) * OutHeight() * OutWidth(); }
+  uint64_t GemmN() const { return outChannels; }
+  uint64_t GemmK() const {
+    return uint64_t(inChannels) * kernelHeight * kernelWidth;
+  }
+  uint64_t Flops() const { return 2 * GemmM() * GemmN() * GemmK(); }
+
+  uint64_t InputSize() const {
+    return uint64_t(batch) * inChannels * inHeight * inWidth;
+  }
+  uint64_t WeightSize() const { return GemmN() * GemmK(); }
+  uint64_t OutputSize() const { return GemmM() * GemmN(); }
+};
+
+class Conv2d {
+public:
+  Conv2d(const wgpu::Device &device, TrackedAllocator &allocator,
+         TensorLayout layout, const Conv2dShape &shape,
+         ConvAlgorithm algorithm);
+
+  // Records the convolution into `encoder`. Buffers hold f32 tensors in the
+  // layouts described above.
+  void Encode(const wgpu::CommandEncoder &encoder, const BufferBinding &input,
+              const BufferBinding &weights, const BufferBinding &output);
+
+private:
+  wgpu::Device device_;
+  Conv2dShape shape_;
+  ConvAlgorithm algorithm_;
+
+  TrackedBuffer paramsBuffer_;
+  // Im2colGemm only: the materialized M x K patch matrix.
+  TrackedBuffer columns_;
+
+  wgpu::ComputePipeline im2colPipeline_;
+  wgpu::ComputePipeline gemmPipeline_;
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "TrackedAllocator.h"
+
+// Helpers shared by the native samples and compute primitives. The blocking
+// ones (GetAdapter/GetDevice from matmult.cpp, queue waits and readbacks)
+// poll the instance until their callback has fired.
+
+// A range of a buffer to bind, as in wgpu::BindGroupEntry.
+struct BufferBinding {
+  wgpu::Buffer buffer;
+  uint64_t offset = 0;
+  uint64_t size = WGPU_WHOLE_SIZE;
+};
+
+struct DeviceOptions {
+  wgpu::BackendType backendType = wgpu::BackendType::Undefined;
+  bool forceFallbackAdapter = false;
+};
+
+inline wgpu::Adapter RequestAdapterSync(const wgpu::Instance &instance,
+                                        const DeviceOptions &options = {}) {
+  struct Request {
+    wgpu::Adapter adapter;
+    bool done = false;
+  } request;
+
+  wgpu::RequestAdapterOptions adapterOptions = {};
+  adapterOptions.backendType = options.backendType;
+  adapterOptions.forceFallbackAdapter = options.forceFallbackAdapter;
+
+  instance.RequestAdapter(
+      &adapterOptions,
+      [](WGPURequestAdapterStatus status, WGPUAdapter cAdapter,
+         const char *message, void *userdata) {
+        if (message) {
+          std::cout << "RequestAdapter message: " << message << std::endl;
+        }
+        if (status != WGPURequestAdapterStatus_Success) {
+          std::cout << "AdapterRequest was not successfull" << std::endl;
+          exit(0);
+        }
+        auto *request = reinterpret_cast<Request *>(userdata);
+        request->adapter = wgpu::Adapter::Acquire(cAdapter);
+        request->done = true;
+      },
+      reinterpret_cast<void *>(&request));
+
+  while (!request.done) {
+    instance.ProcessEvents();
+  }
+  return request.adapter;
+}
+
+inline wgpu::Device
+RequestDeviceSync(const wgpu::Instance &instance, const wgpu::Adapter &adapter,
+                  const wgpu::DeviceDescriptor *descriptor = nullptr) {
+  struct Request {
+    wgpu::Device device;
+    bool done = false;
+  } request;
+
+  adapter.RequestDevice(
+      descriptor,
+      [](WGPURequestDeviceStatus status, WGPUDevice cDevice,
+         const char *message, void *userdata) {
+        if (message) {
+          std::cout << "RequestDevice message: " << message << std::endl;
+        }
+        if (status != WGPURequestDeviceStatus_Success) {
+          std::cout << "DeviceRequest was not successfull" << std::endl;
+          exit(0);
+        }
+        auto *request = reinterpret_cast<Request *>(userdata);
+        request->device = wgpu::Device::Acquire(cDevice);
+        request->device.SetUncapturedErrorCallback(
+            [](WGPUErrorType type, const char *message, void *userdata) {
+              std::cout << "Error: " << type << " - message: " << message
+                        << std::endl;
+            },
+            nullptr);
+        request->done = true;
+      },
+      reinterpret_cast<void *>(&request));
+
+  while (!request.done) {
+    instance.ProcessEvents();
+  }
+  return request.device;
+}
+
+inline wgpu::ShaderModule CreateShaderModule(const wgpu::Device &device,
+                                             const char *code) {
+  wgpu::ShaderModuleWGSLDescriptor shaderModuleDesc = {};
+  shaderModuleDesc.code = code;
+  wgpu::ShaderModuleDescriptor shaderModuleDescriptor{.nextInChain =
+                                                          &shaderModuleDesc};
+  return device.CreateShaderModule(&shaderModuleDescriptor);
+}
+
+// Compute pipeline with an automatic layout and entry point "main".
+inline wgpu::ComputePipeline CreatePipeline(const wgpu::Device &device,
+                                            const std::string &code) {
+  wgpu::ComputePipelineDescriptor pipelineDesc = {};
+  pipelineDesc.compute.module = CreateShaderModule(device, code.c_str());
+  pipelineDesc.compute.entryPoint = "main";
+  return device.CreateComputePipeline(&pipelineDesc);
+}
+
+inline wgpu::BindGroupEntry BindingEntry(uint32_t binding,
+                                         const BufferBinding &buffer) {
+  wgpu::BindGroupEntry entry = {};
+  entry.binding = binding;
+  entry.buffer = buffer.buffer;
+  entry.offset = buffer.offset;
+  entry.size = buffer.size;
+  return entry;
+}
+
+// Bind group 0 of `pipeline`'s automatic layout.
+inline wgpu::BindGroup MakeBindGroup(const wgpu::Device &device,
+                                     const wgpu::ComputePipeline &pipeline,
+                                     const wgpu::BindGroupEntry *entries,
+                                     size_t count) {
+  wgpu::BindGroupDescriptor bindGroupDesc = {};
+  bindGroupDesc.layout = pipeline.GetBindGroupLayout(0);
+  bindGroupDesc.entryCount = count;
+  bindGroupDesc.entries = entries;
+  return device.CreateBindGroup(&bindGroupDesc);
+}
+
+// Splits `groups` workgroups over x and y to stay under the 65535 limit.
+inline void DispatchLinear(const wgpu::ComputePassEncoder &pass,
+                           uint64_t groups) {
+  const uint32_t groupsX = uint32_t(std::min<uint64_t>(groups, 65535));
+  pass.DispatchWorkgroups(groupsX, uint32_t((groups + groupsX - 1) / groupsX));
+}
+
+inline void WaitForQueue(const wgpu::Instance &instance,
+                         const wgpu::Device &device) {
+  bool done = false;
+  device.GetQueue().OnSubmittedWorkDone(
+      [](WGPUQueueWorkDoneStatus status, void *userdata) {
+        *reinterpret_cast<bool *>(userdata) = true;
+      },
+      reinterpret_cast<void *>(&done));
+  while (!done) {
+    instance.ProcessEvents();
+  }
+}
+
+// Copies `size` bytes of `source` into a tracked MapRead buffer and returns
+// them once mapped.
+template <typename T>
+std::vector<T> ReadBack(const wgpu::Instance &instance,
+                        TrackedAllocator &allocator,
+                        const BufferBinding &source, uint64_t size) {
+  const wgpu::Device &device = allocator.GetDevice();
+  wgpu::BufferDescriptor readDesc{
+      .usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead,
+      .size = size,
+  };
+  TrackedBuffer readBuffer = allocator.CreateBuffer(readDesc);
+  wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+  commandEncoder.CopyBufferToBuffer(source.buffer, source.offset,
+                                    readBuffer.Get(), 0, size);
+  wgpu::CommandBuffer commands = commandEncoder.Finish();
+  device.GetQueue().Submit(1, &commands);
+
+  bool done = false;
+  readBuffer.Get().MapAsync(
+      wgpu::MapMode::Read, 0, size,
+      [](WGPUBufferMapAsyncStatus status, void *userdata) {
+        if (status != WGPUBufferMapAsyncStatus_Success) {
+          std::cout << "Failed to map result buffer" << std::endl;
+          exit(1);
+        }
+        *reinterpret_cast<bool *>(userdata) = true;
+      },
+      reinterpret_cast<void *>(&done));
+  while (!done) {
+    instance.ProcessEvents();
+  }
+  const T *data =
+      static_cast<const T *>(readBuffer.Get().GetConstMappedRange(0, size));
+  std::vector<T> result(data, data + size / sizeof(T));
+  readBuffer.Get().Unmap();
+  return result;
+}
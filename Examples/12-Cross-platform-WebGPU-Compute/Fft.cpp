@@ -0,0 +1,452 @@
+#include "Fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+#include "DeviceHelpers.h"
+
+namespace {
+
+constexpr uint32_t kStageWorkgroupSize = 64;
+constexpr uint32_t kMaxSharedWorkgroupSize = 256;
+
+// Host-side mirror of the FftParams uniform.
+struct FftParams {
+  uint32_t n;
+  uint32_t ns; // product of the radices of the previous stages
+  uint32_t count;
+  uint32_t elementStride;
+  uint32_t perGroup;
+  uint32_t groupStride;
+  uint32_t transformStride;
+  float sign; // -1 forward, +1 inverse
+  float scale;
+  uint32_t pad[3];
+};
+
+// Complex helpers from 05-Complex.js, plus the butterflies built on them.
+const char fftCommon[] = R"(
+    struct FftParams {
+        n : u32,
+        ns : u32,
+        count : u32,
+        elementStride : u32,
+        perGroup : u32,
+        groupStride : u32,
+        transformStride : u32,
+        sign : f32,
+        scale : f32,
+    };
+
+    @group(0) @binding(2) var<storage, read> twiddles : array<vec2<f32>>;
+    @group(0) @binding(3) var<uniform> params : FftParams;
+
+    fn addCC(a : vec2<f32>, b : vec2<f32>) -> vec2<f32> {
+      var result = vec2<f32>(0.0, 0.0);
+      result.x = a.x + b.x;
+      result.y = a.y + b.y;
+      return result;
+    }
+
+    fn subCC(a : vec2<f32>, b : vec2<f32>) -> vec2<f32> {
+      var result = vec2<f32>(0.0, 0.0);
+      result.x = a.x - b.x;
+      result.y = a.y - b.y;
+      return result;
+    }
+
+    fn mulCC(a : vec2<f32>, b : vec2<f32>) -> vec2<f32> {
+      var result = vec2<f32>(0.0, 0.0);
+      result.x = a.x * b.x - a.y * b.y;
+      result.y = a.x * b.y + a.y * b.x;
+      return result;
+    }
+
+    fn mulFC(a : f32, b : vec2<f32>) -> vec2<f32> {
+      var result = vec2<f32>(0.0, 0.0);
+      result.x = a * b.x;
+      result.y = a * b.y;
+      return result;
+    }
+
+    // b * (sign * i): a quarter turn, clockwise for the forward transform.
+    fn rotateQuarter(b : vec2<f32>) -> vec2<f32> {
+      return vec2<f32>(-params.sign * b.y, params.sign * b.x);
+    }
+
+    // exp(sign * 2 pi i * index / n); the table holds the forward factors.
+    fn twiddle(index : u32) -> vec2<f32> {
+      let w = twiddles[index];
+      return vec2<f32>(w.x, -params.sign * w.y);
+    }
+
+    fn transformBase(t : u32) -> u32 {
+      return (t / params.perGroup) * params.groupStride +
+             (t % params.perGroup) * params.transformStride;
+    }
+
+    fn butterfly2(x : array<vec2<f32>, 2>) -> array<vec2<f32>, 2> {
+      return array<vec2<f32>, 2>(addCC(x[0], x[1]), subCC(x[0], x[1]));
+    }
+
+    fn dft4(y0 : vec2<f32>, y1 : vec2<f32>, y2 : vec2<f32>,
+            y3 : vec2<f32>) -> array<vec2<f32>, 4> {
+      let t0 = addCC(y0, y2);
+      let t1 = subCC(y0, y2);
+      let t2 = addCC(y1, y3);
+      let t3 = rotateQuarter(subCC(y1, y3));
+      return array<vec2<f32>, 4>(addCC(t0, t2), addCC(t1, t3),
+                                 subCC(t0, t2), subCC(t1, t3));
+    }
+
+    fn butterfly4(x : array<vec2<f32>, 4>) -> array<vec2<f32>, 4> {
+      return dft4(x[0], x[1], x[2], x[3]);
+    }
+
+    // Decimation in frequency: one radix-2 step, then two radix-4 DFTs
+    // giving the even and odd outputs.
+    fn butterfly8(x : array<vec2<f32>, 8>) -> array<vec2<f32>, 8> {
+      let c = 0.70710678118654752;
+      let even = dft4(addCC(x[0], x[4]), addCC(x[1], x[5]),
+                      addCC(x[2], x[6]), addCC(x[3], x[7]));
+      let odd = dft4(subCC(x[0], x[4]),
+                     mulCC(subCC(x[1], x[5]), vec2<f32>(c, params.sign * c)),
+                     rotateQuarter(subCC(x[2], x[6])),
+                     mulCC(subCC(x[3], x[7]), vec2<f32>(-c, params.sign * c)));
+      return array<vec2<f32>, 8>(even[0], odd[0], even[1], odd[1],
+                                 even[2], odd[2], even[3], odd[3]);
+    }
+)";
+
+// One radix-R Stockham stage per dispatch, one butterfly per invocation,
+// reading `src` and writing `dst` in global memory.
+std::string StageShader(uint32_t radix) {
+  const std::string r = std::to_string(radix);
+  return std::string(fftCommon) + R"(
+    @group(0) @binding(0) var<storage, read> src : array<vec2<f32>>;
+    @group(0) @binding(1) var<storage, read_write> dst : array<vec2<f32>>;
+
+    const R : u32 = )" + r + R"(u;
+
+    @compute @workgroup_size()" + std::to_string(kStageWorkgroupSize) + R"()
+    fn main(@builtin(global_invocation_id) globalId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>) {
+        let id = globalId.x + globalId.y * groups.x * )" +
+         std::to_string(kStageWorkgroupSize) + R"(u;
+        let butterflies = params.n / R;
+        if (id >= butterflies * params.count) {
+            return;
+        }
+        let base = transformBase(id / butterflies);
+        let j = id % butterflies;
+        let k = j % params.ns;
+        let step = params.n / (params.ns * R);
+
+        var v : array<vec2<f32>, R>;
+        for (var r = 0u; r < R; r++) {
+            let index = base + (j + r * butterflies) * params.elementStride;
+            v[r] = mulCC(src[index], twiddle(r * k * step));
+        }
+        v = butterfly)" + r + R"((v);
+
+        let first = (j / params.ns) * params.ns * R + k;
+        for (var r = 0u; r < R; r++) {
+            let index = base + (first + r * params.ns) * params.elementStride;
+            dst[index] = mulFC(params.scale, v[r]);
+        }
+    }
+)";
+}
+
+// All stages of an n-point transform in workgroup memory, one workgroup per
+// transform. The stage sequence is unrolled with constant sizes; each stage
+// reads its butterflies into registers, syncs, then writes them back.
+std::string SharedShader(uint32_t n, const std::vector<uint32_t> &radices,
+                         uint32_t workgroupSize) {
+  std::string stages;
+  std::string calls;
+  uint32_t ns = 1;
+  for (size_t s = 0; s < radices.size(); ++s) {
+    const uint32_t radix = radices[s];
+    const uint32_t butterflies = n / radix;
+    const uint32_t perThread =
+        (butterflies + workgroupSize - 1) / workgroupSize;
+    const std::string r = std::to_string(radix);
+    const std::string name = "stage" + std::to_string(s);
+    stages += R"(
+    fn )" + name + R"((lid : u32) {
+        const R = )" + r + R"(u;
+        const NS = )" + std::to_string(ns) + R"(u;
+        const B = )" + std::to_string(butterflies) + R"(u;
+        const P = )" + std::to_string(perThread) + R"(u;
+        var v : array<array<vec2<f32>, R>, P>;
+        for (var p = 0u; p < P; p++) {
+            let j = lid + p * WG;
+            if (j < B) {
+                let k = j % NS;
+                for (var r = 0u; r < R; r++) {
+                    v[p][r] = mulCC(tile[j + r * B], twiddle(r * k * (N / (NS * R))));
+                }
+                v[p] = butterfly)" + r + R"((v[p]);
+            }
+        }
+        workgroupBarrier();
+        for (var p = 0u; p < P; p++) {
+            let j = lid + p * WG;
+            if (j < B) {
+                let first = (j / NS) * NS * R + j % NS;
+                for (var r = 0u; r < R; r++) {
+                    tile[first + r * NS] = v[p][r];
+                }
+            }
+        }
+        workgroupBarrier();
+    }
+)";
+    calls += "        " + name + "(lid);\n";
+    ns *= radix;
+  }
+
+  return std::string(fftCommon) + R"(
+    @group(0) @binding(1) var<storage, read_write> data : array<vec2<f32>>;
+
+    const N : u32 = )" + std::to_string(n) + R"(u;
+    const WG : u32 = )" + std::to_string(workgroupSize) + R"(u;
+
+    var<workgroup> tile : array<vec2<f32>, N>;
+)" + stages + R"(
+    @compute @workgroup_size(WG)
+    fn main(@builtin(workgroup_id) groupId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>,
+            @builtin(local_invocation_index) lid : u32) {
+        let t = groupId.x + groupId.y * groups.x;
+        if (t >= params.count) {
+            return;
+        }
+        let base = transformBase(t);
+        for (var i = lid; i < N; i += WG) {
+            tile[i] = data[base + i * params.elementStride];
+        }
+        workgroupBarrier();
+
+)" + calls + R"(
+        for (var i = lid; i < N; i += WG) {
+            data[base + i * params.elementStride] = mulFC(params.scale, tile[i]);
+        }
+    }
+)";
+}
+
+} // namespace
+
+double FftShape::Flops() const {
+  const double n = double(width) * height;
+  return 5.0 * n * std::log2(n) * batch;
+}
+
+std::vector<uint32_t> Fft::Radices(uint32_t n) {
+  if (n == 0 || (n & (n - 1)) != 0) {
+    throw std::invalid_argument("Fft: length must be a power of two");
+  }
+  uint32_t log2n = 0;
+  while ((1u << log2n) < n) {
+    ++log2n;
+  }
+  // As many radix-8 stages as possible; a leftover factor of 2 is folded
+  // with one of them into two radix-4 stages when there is one.
+  std::vector<uint32_t> radices(log2n / 3, 8);
+  if (log2n % 3 == 2) {
+    radices.push_back(4);
+  } else if (log2n % 3 == 1) {
+    if (radices.empty()) {
+      radices.push_back(2);
+    } else {
+      radices.back() = 4;
+      radices.push_back(4);
+    }
+  }
+  return radices;
+}
+
+Fft::Fft(const wgpu::Device &device, TrackedAllocator &allocator,
+         const FftShape &shape)
+    : device_(device), allocator_(allocator), shape_(shape) {
+  if (shape.Elements() == 0 || shape.Elements() > UINT32_MAX) {
+    throw std::invalid_argument("Fft: unsupported problem size");
+  }
+  wgpu::SupportedLimits limits = {};
+  device_.GetLimits(&limits);
+  maxSharedLength_ =
+      limits.limits.maxComputeWorkgroupStorageSize / (2 * sizeof(float));
+
+  // Rows first, then columns of each batch entry.
+  AddDimension(shape.width, shape.height * shape.batch, 1, 1, shape.width, 0);
+  AddDimension(shape.height, shape.width * shape.batch, shape.width,
+               shape.width, shape.width * shape.height, 1);
+
+  for (const Dimension &dimension : dimensions_) {
+    if (!dimension.shared) {
+      wgpu::BufferDescriptor scratchDesc{
+          .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc,
+          .size = shape.Elements() * 2 * sizeof(float),
+      };
+      scratch_ =
+          allocator_.CreateBuffer(scratchDesc, BufferCategory::Intermediate);
+      break;
+    }
+  }
+}
+
+void Fft::AddDimension(uint32_t n, uint32_t count, uint32_t elementStride,
+                       uint32_t perGroup, uint32_t groupStride,
+                       uint32_t transformStride) {
+  if (n == 1) {
+    return;
+  }
+  Dimension dimension{
+      .n = n,
+      .radices = Radices(n),
+      .shared = n <= maxSharedLength_,
+      .count = count,
+      .twiddles = GetTwiddles(n),
+  };
+
+  const size_t stages = dimension.shared ? 1 : dimension.radices.size();
+  for (FftDirection direction : {FftDirection::Forward, FftDirection::Inverse}) {
+    const bool inverse = direction == FftDirection::Inverse;
+    uint32_t ns = 1;
+    for (size_t s = 0; s < stages; ++s) {
+      const FftParams params{
+          .n = n,
+          .ns = ns,
+          .count = count,
+          .elementStride = elementStride,
+          .perGroup = perGroup,
+          .groupStride = groupStride,
+          .transformStride = transformStride,
+          .sign = inverse ? 1.0f : -1.0f,
+          .scale = inverse && s + 1 == stages ? 1.0f / float(n) : 1.0f,
+      };
+      wgpu::BufferDescriptor paramsDesc{
+          .usage = wgpu::BufferUsage::Uniform,
+          .size = sizeof(params),
+          .mappedAtCreation = true,
+      };
+      TrackedBuffer buffer = allocator_.CreateBuffer(paramsDesc);
+      std::memcpy(buffer.Get().GetMappedRange(), &params, sizeof(params));
+      buffer.Get().Unmap();
+      dimension.params[inverse].push_back(std::move(buffer));
+      ns *= dimension.radices[s];
+    }
+  }
+  dimensions_.push_back(std::move(dimension));
+}
+
+const wgpu::Buffer &Fft::GetTwiddles(uint32_t n) {
+  auto it = twiddles_.find(n);
+  if (it == twiddles_.end()) {
+    // exp(-2 pi i k / n), computed in double precision.
+    std::vector<float> table(2 * size_t(n));
+    for (uint32_t k = 0; k < n; ++k) {
+      const double angle = -2.0 * std::numbers::pi * double(k) / double(n);
+      table[2 * k] = float(std::cos(angle));
+      table[2 * k + 1] = float(std::sin(angle));
+    }
+    wgpu::BufferDescriptor tableDesc{
+        .usage = wgpu::BufferUsage::Storage,
+        .size = table.size() * sizeof(float),
+        .mappedAtCreation = true,
+    };
+    TrackedBuffer buffer = allocator_.CreateBuffer(tableDesc);
+    std::memcpy(buffer.Get().GetMappedRange(), table.data(), tableDesc.size);
+    buffer.Get().Unmap();
+    it = twiddles_.emplace(n, std::move(buffer)).first;
+  }
+  return it->second.Get();
+}
+
+const wgpu::ComputePipeline &Fft::GetStagePipeline(uint32_t radix) {
+  auto it = stagePipelines_.find(radix);
+  if (it == stagePipelines_.end()) {
+    it = stagePipelines_
+             .emplace(radix, CreatePipeline(device_, StageShader(radix)))
+             .first;
+  }
+  return it->second;
+}
+
+const wgpu::ComputePipeline &
+Fft::GetSharedPipeline(const Dimension &dimension) {
+  auto it = sharedPipelines_.find(dimension.n);
+  if (it == sharedPipelines_.end()) {
+    const uint32_t smallest = *std::min_element(dimension.radices.begin(),
+                                                dimension.radices.end());
+    const uint32_t workgroupSize =
+        std::min(kMaxSharedWorkgroupSize, dimension.n / smallest);
+    it = sharedPipelines_
+             .emplace(dimension.n,
+                      CreatePipeline(device_,
+                                     SharedShader(dimension.n,
+                                                  dimension.radices,
+                                                  workgroupSize)))
+             .first;
+  }
+  return it->second;
+}
+
+void Fft::Encode(const wgpu::CommandEncoder &encoder, const BufferBinding &data,
+                 FftDirection direction) {
+  const uint64_t bytes = shape_.Elements() * 2 * sizeof(float);
+  const BufferBinding target{
+      .buffer = data.buffer, .offset = data.offset, .size = bytes};
+  const BufferBinding scratch{.buffer = scratch_.Get(), .size = bytes};
+  const bool inverse = direction == FftDirection::Inverse;
+
+  wgpu::ComputePassEncoder passEncoder = encoder.BeginComputePass();
+  for (const Dimension &dimension : dimensions_) {
+    const BufferBinding twiddles{.buffer = dimension.twiddles};
+    const std::vector<TrackedBuffer> &params = dimension.params[inverse];
+
+    if (dimension.shared) {
+      const wgpu::ComputePipeline &pipeline = GetSharedPipeline(dimension);
+      const wgpu::BindGroupEntry entries[3] = {
+          BindingEntry(1, target), BindingEntry(2, twiddles),
+          BindingEntry(3, {.buffer = params[0].Get()})};
+      passEncoder.SetPipeline(pipeline);
+      passEncoder.SetBindGroup(0, MakeBindGroup(device_, pipeline, entries, 3));
+      DispatchLinear(passEncoder, dimension.count);
+      continue;
+    }
+
+    // Stockham stages are out of place: ping-pong through the scratch buffer
+    // and copy back if the result ends up there.
+    const BufferBinding *src = &target;
+    const BufferBinding *dst = &scratch;
+    for (size_t s = 0; s < dimension.radices.size(); ++s) {
+      const uint32_t radix = dimension.radices[s];
+      const wgpu::ComputePipeline &pipeline = GetStagePipeline(radix);
+      const wgpu::BindGroupEntry entries[4] = {
+          BindingEntry(0, *src), BindingEntry(1, *dst),
+          BindingEntry(2, twiddles),
+          BindingEntry(3, {.buffer = params[s].Get()})};
+      passEncoder.SetPipeline(pipeline);
+      passEncoder.SetBindGroup(0, MakeBindGroup(device_, pipeline, entries, 4));
+      const uint64_t butterflies = uint64_t(dimension.n / radix) *
+                                   dimension.count;
+      DispatchLinear(passEncoder, (butterflies + kStageWorkgroupSize - 1) /
+                                      kStageWorkgroupSize);
+      std::swap(src, dst);
+    }
+    if (src == &scratch) {
+      passEncoder.End();
+      encoder.CopyBufferToBuffer(scratch.buffer, 0, target.buffer,
+                                 target.offset, bytes);
+      passEncoder = encoder.BeginComputePass();
+    }
+  }
+  passEncoder.End();
+}
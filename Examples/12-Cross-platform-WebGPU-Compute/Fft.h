@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmPipeline.h"
+#include "TrackedAllocator.h"
+
+// Batched 1D/2D complex FFT (Stockham autosort) on vec2<f32> data.
+//
+// Each dimension's power-of-two length is split into radix-8 stages plus at
+// most two radix-4 stages, or one radix-2 stage for n = 2. Twiddle factors
+// come from a precomputed table in a storage buffer, one table per distinct
+// length.
+//
+// A dimension whose transform fits in workgroup memory runs all its stages
+// in one dispatch, one workgroup per transform. Longer dimensions run one
+// dispatch per stage, ping-ponging through a scratch buffer in global memory.
+//
+// The butterflies are built on the complex helpers from 05-Complex.js
+// (addCC, mulCC, mulFC, ...).
+
+enum class FftDirection { Forward, Inverse };
+
+struct FftShape {
+  uint32_t width = 1;  // innermost, contiguous dimension
+  uint32_t height = 1; // 1 for a 1D transform
+  uint32_t batch = 1;
+
+  uint64_t Elements() const { return uint64_t(width) * height * batch; }
+  // 5 N log2(N) per transform, the usual FFT FLOP convention.
+  double Flops() const;
+};
+
+class Fft {
+public:
+  Fft(const wgpu::Device &device, TrackedAllocator &allocator,
+      const FftShape &shape);
+
+  // Transforms `data` (Elements() complex values, row-major, batches
+  // back to back) in place. The inverse is scaled by 1 / (width * height).
+  void Encode(const wgpu::CommandEncoder &encoder, const BufferBinding &data,
+              FftDirection direction);
+
+  static std::vector<uint32_t> Radices(uint32_t n);
+
+private:
+  struct Dimension {
+    uint32_t n;
+    std::vector<uint32_t> radices;
+    bool shared; // all stages in workgroup memory
+    uint32_t count;
+    wgpu::Buffer twiddles;
+    // Indexed by [direction][stage]; a single entry for shared dimensions.
+    std::vector<TrackedBuffer> params[2];
+  };
+
+  void AddDimension(uint32_t n, uint32_t count, uint32_t elementStride,
+                    uint32_t perGroup, uint32_t groupStride,
+                    uint32_t transformStride);
+  const wgpu::Buffer &GetTwiddles(uint32_t n);
+  const wgpu::ComputePipeline &GetStagePipeline(uint32_t radix);
+  const wgpu::ComputePipeline &GetSharedPipeline(const Dimension &dimension);
+
+  wgpu::Device device_;
+  TrackedAllocator &allocator_;
+  FftShape shape_;
+  uint32_t maxSharedLength_;
+
+  std::vector<Dimension> dimensions_;
+  std::map<uint32_t, TrackedBuffer> twiddles_;
+  TrackedBuffer scratch_;
+
+  std::map<uint32_t, wgpu::ComputePipeline> stagePipelines_;
+  std::map<uint32_t, wgpu::ComputePipeline> sharedPipelines_;
+};
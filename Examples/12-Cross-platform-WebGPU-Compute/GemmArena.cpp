@@ -0,0 +1,164 @@
+#include "GemmArena.h"
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "DeviceHelpers.h"
+
+namespace {
+
+constexpr uint32_t kDynamicBindings = 3;
+
+} // namespace
+
+GemmArena::GemmArena(const wgpu::Device &device, TrackedAllocator &allocator,
+                     uint64_t size)
+    : device_(device), allocator_(allocator), bindGroups_(device) {
+  wgpu::SupportedLimits limits = {};
+  device_.GetLimits(&limits);
+  if (limits.limits.maxDynamicStorageBuffersPerPipelineLayout <
+      kDynamicBindings) {
+    throw std::runtime_error(
+        "GemmArena: device has too few dynamic storage buffer bindings");
+  }
+  if (size == 0 || size > UINT32_MAX || size > limits.limits.maxBufferSize) {
+    throw std::invalid_argument("GemmArena: unsupported arena size " +
+                                std::to_string(size));
+  }
+  alignment_ = limits.limits.minStorageBufferOffsetAlignment;
+
+  wgpu::BufferDescriptor descriptor{
+      .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc |
+               wgpu::BufferUsage::CopyDst,
+      .size = size,
+  };
+  buffer_ = allocator_.CreateBuffer(descriptor, BufferCategory::Storage);
+  free_[0] = size;
+  freeBytes_ = size;
+
+  wgpu::BindGroupLayoutEntry layoutEntries[4] = {};
+  for (uint32_t i = 0; i < 4; ++i) {
+    layoutEntries[i].binding = i;
+    layoutEntries[i].visibility = wgpu::ShaderStage::Compute;
+    layoutEntries[i].buffer.type = wgpu::BufferBindingType::Storage;
+    layoutEntries[i].buffer.hasDynamicOffset = true;
+  }
+  layoutEntries[3].buffer.type = wgpu::BufferBindingType::Uniform;
+  layoutEntries[3].buffer.hasDynamicOffset = false;
+  wgpu::BindGroupLayoutDescriptor layoutDesc = {};
+  layoutDesc.entryCount = 4;
+  layoutDesc.entries = layoutEntries;
+  layout_ = device_.CreateBindGroupLayout(&layoutDesc);
+
+  wgpu::PipelineLayoutDescriptor pipelineLayoutDesc = {};
+  pipelineLayoutDesc.bindGroupLayoutCount = 1;
+  pipelineLayoutDesc.bindGroupLayouts = &layout_;
+
+  const std::string shaderCode = MakeGemmShader(ArenaGemmSource());
+  wgpu::ComputePipelineDescriptor pipelineDesc = {};
+  pipelineDesc.layout = device_.CreatePipelineLayout(&pipelineLayoutDesc);
+  pipelineDesc.compute.module = CreateShaderModule(device_, shaderCode.c_str());
+  pipelineDesc.compute.entryPoint = "main";
+  pipeline_ = device_.CreateComputePipeline(&pipelineDesc);
+}
+
+bool GemmArena::IsSupported(const wgpu::Device &device) {
+  wgpu::SupportedLimits limits = {};
+  device.GetLimits(&limits);
+  return limits.limits.maxDynamicStorageBuffersPerPipelineLayout >=
+         kDynamicBindings;
+}
+
+std::optional<uint64_t> GemmArena::Allocate(uint64_t size) {
+  size = (size + alignment_ - 1) / alignment_ * alignment_;
+  // First fit. Every allocation is a multiple of the alignment, so every
+  // free range starts aligned.
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    if (it->second < size) {
+      continue;
+    }
+    const uint64_t offset = it->first;
+    const uint64_t remaining = it->second - size;
+    free_.erase(it);
+    if (remaining > 0) {
+      free_[offset + size] = remaining;
+    }
+    allocated_[offset] = size;
+    freeBytes_ -= size;
+    return offset;
+  }
+  return std::nullopt;
+}
+
+void GemmArena::Free(uint64_t offset) {
+  auto allocated = allocated_.find(offset);
+  if (allocated == allocated_.end()) {
+    throw std::invalid_argument("GemmArena::Free: no range at offset " +
+                                std::to_string(offset));
+  }
+  uint64_t size = allocated->second;
+  allocated_.erase(allocated);
+  freeBytes_ += size;
+
+  auto next = free_.lower_bound(offset);
+  if (next != free_.end() && offset + size == next->first) {
+    size += next->second;
+    next = free_.erase(next);
+  }
+  if (next != free_.begin()) {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second == offset) {
+      previous->second += size;
+      return;
+    }
+  }
+  free_[offset] = size;
+}
+
+const wgpu::Buffer &GemmArena::GetParamsBuffer(uint32_t m, uint32_t n,
+                                               uint32_t k) {
+  TrackedBuffer &params = paramsBuffers_[{m, n, k}];
+  if (!params) {
+    const GemmParams values{.m = m, .n = n, .k = k};
+    wgpu::BufferDescriptor descriptor{
+        .usage = wgpu::BufferUsage::Uniform,
+        .size = sizeof(values),
+        .mappedAtCreation = true,
+    };
+    params = allocator_.CreateBuffer(descriptor);
+    std::memcpy(params.Get().GetMappedRange(), &values, sizeof(values));
+    params.Get().Unmap();
+  }
+  return params.Get();
+}
+
+void GemmArena::Dispatch(const wgpu::ComputePassEncoder &pass, uint64_t a,
+                         uint64_t b, uint64_t c, uint32_t m, uint32_t n,
+                         uint32_t k) {
+  // Bound at offset 0 with the operand sizes; the dynamic offsets below move
+  // each window to its range.
+  const uint64_t sizes[kDynamicBindings] = {
+      uint64_t(m) * k * sizeof(float),
+      uint64_t(k) * n * sizeof(float),
+      uint64_t(m) * n * sizeof(float),
+  };
+  wgpu::BindGroupEntry entries[4] = {};
+  for (uint32_t i = 0; i < kDynamicBindings; ++i) {
+    entries[i].binding = i;
+    entries[i].buffer = buffer_.Get();
+    entries[i].size = sizes[i];
+  }
+  entries[3].binding = 3;
+  entries[3].buffer = GetParamsBuffer(m, n, k);
+  wgpu::BindGroup bindGroup = bindGroups_.Get(layout_, entries, 4);
+
+  // In binding order, as SetBindGroup expects.
+  const uint32_t offsets[kDynamicBindings] = {uint32_t(a), uint32_t(b),
+                                              uint32_t(c)};
+  pass.SetPipeline(pipeline_);
+  pass.SetBindGroup(0, bindGroup, kDynamicBindings, offsets);
+  pass.DispatchWorkgroups((n + kGemmTileN - 1) / kGemmTileN,
+                          (m + kGemmTileM - 1) / kGemmTileM);
+}
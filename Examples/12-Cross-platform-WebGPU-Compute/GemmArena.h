@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <webgpu/webgpu_cpp.h>
+
+#include "BindGroupCache.h"
+#include "GemmKernel.h"
+#include "TrackedAllocator.h"
+
+// GEMM operands suballocated from one large storage buffer.
+//
+// The arena's pipeline has an explicit layout in which A, B and C are
+// dynamic-offset bindings of the arena buffer. All products of one shape
+// therefore share a single bind group, created on first use, and each
+// Dispatch() only passes three new offsets to SetBindGroup: no bind group is
+// created on the hot path.
+//
+// This needs three dynamic storage buffers per pipeline layout
+// (maxDynamicStorageBuffersPerPipelineLayout, 4 by default), and every range
+// starts at a multiple of minStorageBufferOffsetAlignment. Dynamic offsets
+// are 32-bit, so the arena is at most 4 GiB.
+//
+// Not thread-safe; use it from the thread that records commands. The
+// allocator must outlive the arena.
+class GemmArena {
+public:
+  GemmArena(const wgpu::Device &device, TrackedAllocator &allocator,
+            uint64_t size);
+
+  // Whether `device` has enough dynamic storage buffer bindings.
+  static bool IsSupported(const wgpu::Device &device);
+
+  // Offset of a free range of `size` bytes, or nothing when no free range is
+  // large enough.
+  std::optional<uint64_t> Allocate(uint64_t size);
+  // Returns a range from Allocate(). Only free it once the GPU is done with
+  // it.
+  void Free(uint64_t offset);
+
+  // Records C[m x n] = A[m x k] * B[k x n] into `pass`. `a`, `b` and `c` are
+  // offsets of arena ranges large enough for the operands.
+  void Dispatch(const wgpu::ComputePassEncoder &pass, uint64_t a, uint64_t b,
+                uint64_t c, uint32_t m, uint32_t n, uint32_t k);
+
+  const wgpu::Buffer &GetBuffer() const { return buffer_.Get(); }
+  uint64_t GetFreeBytes() const { return freeBytes_; }
+  BindGroupCache::Stats GetBindGroupStats() const {
+    return bindGroups_.GetStats();
+  }
+
+private:
+  const wgpu::Buffer &GetParamsBuffer(uint32_t m, uint32_t n, uint32_t k);
+
+  wgpu::Device device_;
+  TrackedAllocator &allocator_;
+  uint64_t alignment_ = 256;
+  TrackedBuffer buffer_;
+  wgpu::BindGroupLayout layout_;
+  wgpu::ComputePipeline pipeline_;
+  // One bind group per shape: the binding sizes are the operand sizes.
+  BindGroupCache bindGroups_;
+  std::map<std::tuple<uint32_t, uint32_t, uint32_t>, TrackedBuffer>
+      paramsBuffers_;
+
+  // Free ranges (offset -> size), adjacent ones merged, and allocated ones.
+  std::map<uint64_t, uint64_t> free_;
+  std::map<uint64_t, uint64_t> allocated_;
+  uint64_t freeBytes_ = 0;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Tiled GEMM compute kernel, C[M x N] = A[M x K] * B[K x N].
+//
+// Each 16x16 workgroup computes a 64x64 tile of C. A and B are staged through
+// workgroup memory 16 columns/rows at a time and every invocation accumulates
+// a 4x4 micro-tile in registers.
+//
+// The kernel never touches the operand buffers directly. It calls three
+// functions that the caller supplies, so the same micro-kernel can read
+// operands from plain row-major buffers, from gathered convolution patches,
+// or write results through a fused epilogue:
+//
+//   fn loadA(row : u32, col : u32) -> f32   (must return 0 out of bounds)
+//   fn loadB(row : u32, col : u32) -> f32   (must return 0 out of bounds)
+//   fn storeC(row : u32, col : u32, value : f32)
+//
+// The declarations must also provide a `params` variable with u32 fields
+// M, N and K.
+
+constexpr uint32_t kGemmTileM = 64;
+constexpr uint32_t kGemmTileN = 64;
+
+struct GemmShaderSource {
+  std::string declarations;
+  std::string loadA;
+  std::string loadB;
+  std::string storeC;
+};
+
+inline std::string MakeGemmShader(const GemmShaderSource &source) {
+  return source.declarations + source.loadA + source.loadB + source.storeC +
+         R"(
+    var<workgroup> tileA : array<array<f32, 64>, 16>;
+    var<workgroup> tileB : array<array<f32, 64>, 16>;
+
+    @compute @workgroup_size(16, 16)
+    fn main(@builtin(workgroup_id) groupId : vec3<u32>,
+            @builtin(local_invocation_id) localId : vec3<u32>) {
+        let rowBase = groupId.y * 64u;
+        let colBase = groupId.x * 64u;
+        let tid = localId.y * 16u + localId.x;
+
+        var acc : array<array<f32, 4>, 4>;
+        var a : array<f32, 4>;
+        var b : array<f32, 4>;
+
+        for (var k0 = 0u; k0 < params.K; k0 = k0 + 16u) {
+            // 256 invocations cooperatively load a 64x16 tile of A and a
+            // 16x64 tile of B, four elements each.
+            for (var i = 0u; i < 4u; i = i + 1u) {
+                let idx = tid + i * 256u;
+                let ar = idx / 16u;
+                let ac = idx % 16u;
+                tileA[ac][ar] = loadA(rowBase + ar, k0 + ac);
+                let br = idx / 64u;
+                let bc = idx % 64u;
+                tileB[br][bc] = loadB(k0 + br, colBase + bc);
+            }
+            workgroupBarrier();
+
+            for (var k = 0u; k < 16u; k = k + 1u) {
+                for (var i = 0u; i < 4u; i = i + 1u) {
+                    a[i] = tileA[k][localId.y * 4u + i];
+                    b[i] = tileB[k][localId.x * 4u + i];
+                }
+                for (var i = 0u; i < 4u; i = i + 1u) {
+                    for (var j = 0u; j < 4u; j = j + 1u) {
+                        acc[i][j] = fma(a[i], b[j], acc[i][j]);
+                    }
+                }
+            }
+            workgroupBarrier();
+        }
+
+        for (var i = 0u; i < 4u; i = i + 1u) {
+            for (var j = 0u; j < 4u; j = j + 1u) {
+                let row = rowBase + localId.y * 4u + i;
+                let col = colBase + localId.x * 4u + j;
+                if (row < params.M && col < params.N) {
+                    storeC(row, col, acc[i][j]);
+                }
+            }
+        }
+    }
+)";
+}
+
+// Plain row-major operands:
+//   binding 0: A, binding 1: B, binding 2: C, binding 3: GemmParams uniform.
+inline GemmShaderSource DefaultGemmSource() {
+  return GemmShaderSource{
+      .declarations = R"(
+    struct GemmParams {
+        M : u32,
+        N : u32,
+        K : u32,
+        pad : u32,
+    };
+
+    @group(0) @binding(0) var<storage, read> firstMatrix : array<f32>;
+    @group(0) @binding(1) var<storage, read> secondMatrix : array<f32>;
+    @group(0) @binding(2) var<storage, read_write> resultMatrix : array<f32>;
+    @group(0) @binding(3) var<uniform> params : GemmParams;
+)",
+      .loadA = R"(
+    fn loadA(row : u32, col : u32) -> f32 {
+        if (row >= params.M || col >= params.K) {
+            return 0.0;
+        }
+        return firstMatrix[row * params.K + col];
+    }
+)",
+      .loadB = R"(
+    fn loadB(row : u32, col : u32) -> f32 {
+        if (row >= params.K || col >= params.N) {
+            return 0.0;
+        }
+        return secondMatrix[row * params.N + col];
+    }
+)",
+      .storeC = R"(
+    fn storeC(row : u32, col : u32, value : f32) {
+        resultMatrix[row * params.N + col] = value;
+    }
+)",
+  };
+}
+
+// DefaultGemmSource() with A and B declared read_write, for operands that
+// live in the same buffer as C (see GemmArena). WebGPU does not let one
+// dispatch use a buffer as both read-only and writable storage.
+inline GemmShaderSource ArenaGemmSource() {
+  GemmShaderSource source = DefaultGemmSource();
+  const std::string readOnly = "var<storage, read>";
+  for (size_t at = source.declarations.find(readOnly); at != std::string::npos;
+       at = source.declarations.find(readOnly, at)) {
+    source.declarations.replace(at, readOnly.size(), "var<storage, read_write>");
+  }
+  return source;
+}
+
+// Work applied to each output element before it is stored, fused into the
+// GEMM so it costs no extra pass over C.
+struct GemmEpilogue {
+  enum class Bias {
+    None,
+    Matrix, // C[row][col] += bias[row][col], bias is M x N
+    Row,    // C[row][col] += bias[col], bias is 1 x N
+  };
+
+  Bias bias = Bias::None;
+  bool relu = false;
+};
+
+// DefaultGemmSource() plus the epilogue. The bias, if any, is bound at
+// binding 4.
+inline GemmShaderSource GemmSourceWithEpilogue(const GemmEpilogue &epilogue) {
+  GemmShaderSource source = DefaultGemmSource();
+  if (epilogue.bias == GemmEpilogue::Bias::None && !epilogue.relu) {
+    return source;
+  }
+
+  std::string body;
+  if (epilogue.bias != GemmEpilogue::Bias::None) {
+    source.declarations += R"(
+    @group(0) @binding(4) var<storage, read> bias : array<f32>;
+)";
+    body += epilogue.bias == GemmEpilogue::Bias::Matrix
+                ? "        result = result + bias[row * params.N + col];\n"
+                : "        result = result + bias[col];\n";
+  }
+  if (epilogue.relu) {
+    body += "        result = max(result, 0.0);\n";
+  }
+  source.storeC = R"(
+    fn storeC(row : u32, col : u32, value : f32) {
+        var result = value;
+)" + body + R"(        resultMatrix[row * params.N + col] = result;
+    }
+)";
+  return source;
+}
+
+// Host-side mirror of the GemmParams uniform.
+struct GemmParams {
+  uint32_t m;
+  uint32_t n;
+  uint32_t k;
+  uint32_t pad;
+};
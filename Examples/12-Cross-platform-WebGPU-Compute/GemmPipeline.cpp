@@ -0,0 +1,63 @@
+#include "GemmPipeline.h"
+
+#include <cstring>
+#include <string>
+
+#include "DeviceHelpers.h"
+
+GemmPipeline::GemmPipeline(const wgpu::Device &device,
+                           TrackedAllocator &allocator,
+                           const GemmShaderSource &source,
+                           size_t bindGroupCacheSize)
+    : device_(device), allocator_(allocator),
+      bindGroups_(device, bindGroupCacheSize) {
+  pipeline_ = CreatePipeline(device_, MakeGemmShader(source));
+  layout_ = pipeline_.GetBindGroupLayout(0);
+}
+
+const wgpu::Buffer &GemmPipeline::GetParamsBuffer(uint32_t m, uint32_t n,
+                                                  uint32_t k) {
+  TrackedBuffer &params = paramsBuffers_[{m, n, k}];
+  if (!params) {
+    const GemmParams values{.m = m, .n = n, .k = k};
+    wgpu::BufferDescriptor descriptor{
+        .usage = wgpu::BufferUsage::Uniform,
+        .size = sizeof(values),
+        .mappedAtCreation = true,
+    };
+    params = allocator_.CreateBuffer(descriptor);
+    std::memcpy(params.Get().GetMappedRange(), &values, sizeof(values));
+    params.Get().Unmap();
+  }
+  return params.Get();
+}
+
+void GemmPipeline::Dispatch(const wgpu::ComputePassEncoder &pass,
+                            const BufferBinding &a, const BufferBinding &b,
+                            const BufferBinding &c, uint32_t m, uint32_t n,
+                            uint32_t k, const BufferBinding *bias) {
+  wgpu::BindGroupEntry entries[5] = {};
+  const BufferBinding *bindings[3] = {&a, &b, &c};
+  for (uint32_t i = 0; i < 3; ++i) {
+    entries[i].binding = i;
+    entries[i].buffer = bindings[i]->buffer;
+    entries[i].offset = bindings[i]->offset;
+    entries[i].size = bindings[i]->size;
+  }
+  entries[3].binding = 3;
+  entries[3].buffer = GetParamsBuffer(m, n, k);
+  if (bias != nullptr) {
+    entries[4].binding = 4;
+    entries[4].buffer = bias->buffer;
+    entries[4].offset = bias->offset;
+    entries[4].size = bias->size;
+  }
+
+  wgpu::BindGroup bindGroup =
+      bindGroups_.Get(layout_, entries, bias != nullptr ? 5 : 4);
+
+  pass.SetPipeline(pipeline_);
+  pass.SetBindGroup(0, bindGroup);
+  pass.DispatchWorkgroups((n + kGemmTileN - 1) / kGemmTileN,
+                          (m + kGemmTileM - 1) / kGemmTileM);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <webgpu/webgpu_cpp.h>
+
+#include "BindGroupCache.h"
+#include "DeviceHelpers.h"
+#include "GemmKernel.h"
+#include "TrackedAllocator.h"
+
+// Compute pipeline for a GEMM shader with the binding layout of
+// DefaultGemmSource(): A, B, C at bindings 0-2 and the GemmParams uniform at
+// binding 3. Params uniforms are created once per shape and reused. Callers
+// that bind the same ranges over and over can pass a bind group cache size
+// to reuse bind groups as well (see BindGroupCache); it is off by default
+// because cached bind groups keep their buffers alive.
+//
+// Not thread-safe; use it from the thread that records commands. The
+// allocator must outlive the pipeline.
+class GemmPipeline {
+public:
+  GemmPipeline(const wgpu::Device &device, TrackedAllocator &allocator,
+               const GemmShaderSource &source = DefaultGemmSource(),
+               size_t bindGroupCacheSize = 0);
+
+  // Records C[m x n] = A[m x k] * B[k x n] into `pass`. `bias` is bound at
+  // binding 4 for shaders with a bias epilogue.
+  void Dispatch(const wgpu::ComputePassEncoder &pass, const BufferBinding &a,
+                const BufferBinding &b, const BufferBinding &c, uint32_t m,
+                uint32_t n, uint32_t k, const BufferBinding *bias = nullptr);
+
+  const wgpu::ComputePipeline &GetPipeline() const { return pipeline_; }
+  BindGroupCache &GetBindGroupCache() { return bindGroups_; }
+
+private:
+  const wgpu::Buffer &GetParamsBuffer(uint32_t m, uint32_t n, uint32_t k);
+
+  wgpu::Device device_;
+  TrackedAllocator &allocator_;
+  wgpu::ComputePipeline pipeline_;
+  wgpu::BindGroupLayout layout_;
+  BindGroupCache bindGroups_;
+  std::map<std::tuple<uint32_t, uint32_t, uint32_t>, TrackedBuffer>
+      paramsBuffers_;
+};
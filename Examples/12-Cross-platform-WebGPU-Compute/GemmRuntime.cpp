@@ -0,0 +1,260 @@
+#include "GemmRuntime.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+struct GemmRuntime::Job : MpscNode {
+  uint32_t m = 0;
+  uint32_t n = 0;
+  uint32_t k = 0;
+  std::vector<float> a;
+  std::vector<float> b;
+  std::promise<std::vector<float>> promise;
+
+  GemmRuntime *runtime = nullptr;
+  // Arena ranges, freed when the job completes.
+  bool inArena = false;
+  uint64_t firstOffset = 0;
+  uint64_t secondOffset = 0;
+  uint64_t resultOffset = 0;
+  // Outside the arena: released, and accounted as such, when the job
+  // completes.
+  TrackedBuffer firstMatrix;
+  TrackedBuffer secondMatrix;
+  TrackedBuffer resultMatrix;
+  TrackedBuffer readBuffer;
+  size_t resultSize = 0;
+};
+
+GemmRuntime::GemmRuntime(wgpu::Instance instance, wgpu::Device device)
+    : GemmRuntime(std::move(instance), std::move(device), Options{}) {}
+
+GemmRuntime::GemmRuntime(wgpu::Instance instance, wgpu::Device device,
+                         Options options)
+    : instance_(std::move(instance)), device_(std::move(device)),
+      options_(options), allocator_(device_), gemm_(device_, allocator_),
+      uploader_(instance_, device_, allocator_, options_.upload) {
+  if (options_.arenaSize > 0 && GemmArena::IsSupported(device_)) {
+    arena_ = std::make_unique<GemmArena>(device_, allocator_,
+                                         options_.arenaSize);
+  }
+  submitter_ = std::thread(&GemmRuntime::SubmitterLoop, this);
+}
+
+GemmRuntime::~GemmRuntime() {
+  stopping_.store(true, std::memory_order_release);
+  submitted_.fetch_add(1, std::memory_order_release);
+  submitted_.notify_one();
+  submitter_.join();
+}
+
+std::future<std::vector<float>> GemmRuntime::Submit(uint32_t m, uint32_t n,
+                                                    uint32_t k,
+                                                    std::vector<float> a,
+                                                    std::vector<float> b) {
+  auto *job = new Job;
+  std::future<std::vector<float>> future = job->promise.get_future();
+
+  if (m == 0 || n == 0 || k == 0 || a.size() != size_t(m) * k ||
+      b.size() != size_t(k) * n) {
+    job->promise.set_exception(std::make_exception_ptr(
+        std::invalid_argument("GemmRuntime::Submit: shape mismatch")));
+    delete job;
+    return future;
+  }
+
+  job->m = m;
+  job->n = n;
+  job->k = k;
+  job->a = std::move(a);
+  job->b = std::move(b);
+  job->runtime = this;
+
+  queue_.Push(job);
+  submitted_.fetch_add(1, std::memory_order_release);
+  submitted_.notify_one();
+  return future;
+}
+
+void GemmRuntime::PrintMemoryReport(std::ostream &out) const {
+  allocator_.PrintReport(out);
+}
+
+GemmRuntime::Stats GemmRuntime::GetStats() const {
+  return Stats{
+      .jobs = completedJobs_.load(std::memory_order_relaxed),
+      .batches = submittedBatches_.load(std::memory_order_relaxed),
+      .arenaJobs = arenaJobs_.load(std::memory_order_relaxed),
+  };
+}
+
+void GemmRuntime::SubmitterLoop() {
+  std::vector<Job *> batch;
+  batch.reserve(options_.maxBatch);
+
+  while (true) {
+    // Read the counter before draining, so a Submit that races with an empty
+    // Pop changes it and the wait below returns immediately.
+    const uint64_t seen = submitted_.load(std::memory_order_acquire);
+
+    while (batch.size() < options_.maxBatch) {
+      Job *job = queue_.Pop();
+      if (job == nullptr) {
+        break;
+      }
+      batch.push_back(job);
+    }
+
+    if (!batch.empty()) {
+      EncodeAndSubmit(batch);
+      batch.clear();
+    }
+
+    if (inFlight_ > 0) {
+      // Readbacks are pending, keep the device ticking.
+      instance_.ProcessEvents();
+      std::this_thread::yield();
+      continue;
+    }
+
+    if (stopping_.load(std::memory_order_acquire)) {
+      // Only leave once every job pushed before shutdown has been served.
+      Job *job = queue_.Pop();
+      if (job == nullptr) {
+        break;
+      }
+      batch.push_back(job);
+      continue;
+    }
+
+    submitted_.wait(seen, std::memory_order_acquire);
+  }
+}
+
+bool GemmRuntime::AllocateInArena(Job &job) {
+  if (!arena_) {
+    return false;
+  }
+  const std::optional<uint64_t> first =
+      arena_->Allocate(job.a.size() * sizeof(float));
+  const std::optional<uint64_t> second =
+      first ? arena_->Allocate(job.b.size() * sizeof(float)) : std::nullopt;
+  const std::optional<uint64_t> result =
+      second ? arena_->Allocate(job.resultSize) : std::nullopt;
+  if (!result) {
+    if (first) {
+      arena_->Free(*first);
+    }
+    if (second) {
+      arena_->Free(*second);
+    }
+    return false;
+  }
+  job.inArena = true;
+  job.firstOffset = *first;
+  job.secondOffset = *second;
+  job.resultOffset = *result;
+  return true;
+}
+
+void GemmRuntime::EncodeAndSubmit(std::vector<Job *> &batch) {
+  wgpu::CommandEncoder commandEncoder = device_.CreateCommandEncoder();
+  wgpu::ComputePassEncoder passEncoder = commandEncoder.BeginComputePass();
+
+  for (Job *job : batch) {
+    const uint64_t firstSize = job->a.size() * sizeof(float);
+    const uint64_t secondSize = job->b.size() * sizeof(float);
+    job->resultSize = size_t(job->m) * job->n * sizeof(float);
+
+    if (AllocateInArena(*job)) {
+      const wgpu::Buffer &arena = arena_->GetBuffer();
+      uploader_.Write(arena, job->firstOffset, job->a.data(), firstSize);
+      uploader_.Write(arena, job->secondOffset, job->b.data(), secondSize);
+      arena_->Dispatch(passEncoder, job->firstOffset, job->secondOffset,
+                       job->resultOffset, job->m, job->n, job->k);
+      arenaJobs_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      job->firstMatrix = uploader_.CreateBufferWithData(
+          wgpu::BufferUsage::Storage, job->a.data(), firstSize);
+      job->secondMatrix = uploader_.CreateBufferWithData(
+          wgpu::BufferUsage::Storage, job->b.data(), secondSize);
+
+      wgpu::BufferDescriptor resultDesc{
+          .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc,
+          .size = job->resultSize,
+      };
+      job->resultMatrix = allocator_.CreateBuffer(resultDesc);
+
+      gemm_.Dispatch(passEncoder, {.buffer = job->firstMatrix.Get()},
+                     {.buffer = job->secondMatrix.Get()},
+                     {.buffer = job->resultMatrix.Get()}, job->m, job->n,
+                     job->k);
+    }
+
+    // Host copies are no longer needed once the data is on the device.
+    job->a = {};
+    job->b = {};
+
+    wgpu::BufferDescriptor readDesc{
+        .usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead,
+        .size = job->resultSize,
+    };
+    job->readBuffer = allocator_.CreateBuffer(readDesc);
+  }
+  passEncoder.End();
+
+  for (Job *job : batch) {
+    if (job->inArena) {
+      commandEncoder.CopyBufferToBuffer(arena_->GetBuffer(), job->resultOffset,
+                                        job->readBuffer.Get(), 0,
+                                        job->resultSize);
+    } else {
+      commandEncoder.CopyBufferToBuffer(job->resultMatrix.Get(), 0,
+                                        job->readBuffer.Get(), 0,
+                                        job->resultSize);
+    }
+  }
+
+  // Staged uploads must reach the queue before the work that reads them.
+  uploader_.Flush();
+  wgpu::CommandBuffer commands = commandEncoder.Finish();
+  device_.GetQueue().Submit(1, &commands);
+  submittedBatches_.fetch_add(1, std::memory_order_relaxed);
+
+  for (Job *job : batch) {
+    ++inFlight_;
+    job->readBuffer.Get().MapAsync(wgpu::MapMode::Read, 0, job->resultSize,
+                                   &GemmRuntime::OnJobMapped,
+                                   reinterpret_cast<void *>(job));
+  }
+}
+
+void GemmRuntime::OnJobMapped(WGPUBufferMapAsyncStatus status,
+                              void *userdata) {
+  Job *job = reinterpret_cast<Job *>(userdata);
+  GemmRuntime *runtime = job->runtime;
+
+  if (status == WGPUBufferMapAsyncStatus_Success) {
+    const float *resultData = static_cast<const float *>(
+        job->readBuffer.Get().GetConstMappedRange(0, job->resultSize));
+    std::vector<float> result(resultData,
+                              resultData + job->resultSize / sizeof(float));
+    job->readBuffer.Get().Unmap();
+    job->promise.set_value(std::move(result));
+  } else {
+    job->promise.set_exception(std::make_exception_ptr(std::runtime_error(
+        "Failed to map result buffer, status: " + std::to_string(status))));
+  }
+
+  // The readback has finished, so the GPU is done with the job's ranges.
+  if (job->inArena) {
+    runtime->arena_->Free(job->firstOffset);
+    runtime->arena_->Free(job->secondOffset);
+    runtime->arena_->Free(job->resultOffset);
+  }
+
+  --runtime->inFlight_;
+  runtime->completedJobs_.fetch_add(1, std::memory_order_relaxed);
+  delete job;
+}
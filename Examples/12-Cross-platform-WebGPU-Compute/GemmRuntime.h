@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmArena.h"
+#include "GemmPipeline.h"
+#include "MpscQueue.h"
+#include "TrackedAllocator.h"
+#include "UploadEngine.h"
+
+// GemmRuntime owns a device and lets any number of host threads submit GEMM
+// jobs at the same time.
+//
+// Submit() only pushes the job onto a lock-free MPSC queue and returns a
+// future. A single submitter thread is the only thread that ever calls into
+// Dawn: it drains the queue, encodes up to `maxBatch` jobs into one command
+// buffer, submits it, and completes each job's future from its MapAsync
+// callback. Batches are pipelined, so the submitter keeps encoding new work
+// while earlier batches are still being read back. Operands are uploaded
+// through an UploadEngine. Its calibration uploads a few hundred MB, so it is
+// off unless `Options::upload` asks for it.
+//
+// Where the device allows it, operands live in a GemmArena, so dispatches
+// reuse one bind group per shape and only change its dynamic offsets. Jobs
+// that do not fit in the arena's free space get buffers of their own.
+//
+// Once a device is handed to the runtime, the caller must not use it (or its
+// instance) from any other thread.
+class GemmRuntime {
+public:
+  struct Options {
+    size_t maxBatch = 32;
+    UploadEngine::Options upload{.calibrate = false};
+    // 0 disables the arena.
+    uint64_t arenaSize = 64 << 20;
+  };
+
+  struct Stats {
+    uint64_t jobs = 0;
+    uint64_t batches = 0;
+    // Jobs whose operands were placed in the arena.
+    uint64_t arenaJobs = 0;
+  };
+
+  GemmRuntime(wgpu::Instance instance, wgpu::Device device);
+  GemmRuntime(wgpu::Instance instance, wgpu::Device device, Options options);
+  ~GemmRuntime();
+
+  GemmRuntime(const GemmRuntime &) = delete;
+  GemmRuntime &operator=(const GemmRuntime &) = delete;
+
+  // C[m x n] = A[m x k] * B[k x n], all row-major. Thread-safe.
+  std::future<std::vector<float>> Submit(uint32_t m, uint32_t n, uint32_t k,
+                                         std::vector<float> a,
+                                         std::vector<float> b);
+
+  Stats GetStats() const;
+
+  // Live and peak device memory of the runtime's buffers. Thread-safe.
+  void PrintMemoryReport(std::ostream &out) const;
+
+private:
+  struct Job;
+
+  void SubmitterLoop();
+  void EncodeAndSubmit(std::vector<Job *> &batch);
+  bool AllocateInArena(Job &job);
+  static void OnJobMapped(WGPUBufferMapAsyncStatus status, void *userdata);
+
+  wgpu::Instance instance_;
+  wgpu::Device device_;
+  Options options_;
+
+  // Only used by the submitter thread, except for the allocator's reports.
+  TrackedAllocator allocator_;
+  GemmPipeline gemm_;
+  UploadEngine uploader_;
+  std::unique_ptr<GemmArena> arena_;
+
+  MpscQueue<Job> queue_;
+  // Bumped by every Submit; the submitter sleeps on it when idle.
+  std::atomic<uint64_t> submitted_{0};
+  std::atomic<bool> stopping_{false};
+
+  // Only touched by the submitter thread.
+  size_t inFlight_ = 0;
+
+  std::atomic<uint64_t> completedJobs_{0};
+  std::atomic<uint64_t> submittedBatches_{0};
+  std::atomic<uint64_t> arenaJobs_{0};
+
+  std::thread submitter_;
+};
@@ -0,0 +1,309 @@
+#include "MatrixExpr.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include "DeviceHelpers.h"
+
+namespace {
+
+// out[i] = a[i] + b[i] (b optionally broadcast as a row), or max(a[i], 0).
+const char elementwiseShaderCode[] = R"(
+    struct ElementwiseParams {
+        count : u32,
+        cols : u32,
+        op : u32,          // 0: add, 1: relu
+        broadcastRow : u32,
+    };
+
+    @group(0) @binding(0) var<storage, read> lhs : array<f32>;
+    @group(0) @binding(1) var<storage, read> rhs : array<f32>;
+    @group(0) @binding(2) var<storage, read_write> result : array<f32>;
+    @group(0) @binding(3) var<uniform> params : ElementwiseParams;
+
+    @compute @workgroup_size(256)
+    fn main(@builtin(global_invocation_id) globalId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>) {
+        let i = globalId.x + globalId.y * groups.x * 256u;
+        if (i >= params.count) {
+            return;
+        }
+        if (params.op == 1u) {
+            result[i] = max(lhs[i], 0.0);
+            return;
+        }
+        var j = i;
+        if (params.broadcastRow == 1u) {
+            j = i % params.cols;
+        }
+        result[i] = lhs[i] + rhs[j];
+    }
+)";
+
+struct ElementwiseParams {
+  uint32_t count;
+  uint32_t cols;
+  uint32_t op;
+  uint32_t broadcastRow;
+};
+
+bool IsFusableBias(const ExprNode &product, const ExprNode &bias) {
+  return bias.cols == product.cols &&
+         (bias.rows == product.rows || bias.rows == 1);
+}
+
+} // namespace
+
+// Records one expression graph into a single compute pass.
+class ExprEvaluator {
+public:
+  explicit ExprEvaluator(MatrixContext &context)
+      : context_(context),
+        commandEncoder_(context.device_.CreateCommandEncoder()),
+        passEncoder_(commandEncoder_.BeginComputePass()) {}
+
+  Matrix Run(const ExprNode &node) {
+    Matrix result = Eval(node);
+    passEncoder_.End();
+    wgpu::CommandBuffer commands = commandEncoder_.Finish();
+    context_.device_.GetQueue().Submit(1, &commands);
+    return result;
+  }
+
+  std::string Plan() const { return plan_.str(); }
+
+private:
+  Matrix Eval(const ExprNode &node) {
+    switch (node.kind) {
+    case ExprNode::Kind::Leaf:
+      return node.leaf;
+
+    case ExprNode::Kind::MatMul:
+      return EvalProduct(node, nullptr, false);
+
+    case ExprNode::Kind::Add:
+      if (node.lhs->kind == ExprNode::Kind::MatMul &&
+          IsFusableBias(*node.lhs, *node.rhs)) {
+        return EvalProduct(*node.lhs, node.rhs.get(), false);
+      }
+      if (node.rhs->kind == ExprNode::Kind::MatMul &&
+          IsFusableBias(*node.rhs, *node.lhs)) {
+        return EvalProduct(*node.rhs, node.lhs.get(), false);
+      }
+      return Elementwise(Eval(*node.lhs), Eval(*node.rhs), 0);
+
+    case ExprNode::Kind::Relu: {
+      const ExprNode &input = *node.lhs;
+      if (input.kind == ExprNode::Kind::MatMul) {
+        return EvalProduct(input, nullptr, true);
+      }
+      if (input.kind == ExprNode::Kind::Add) {
+        if (input.lhs->kind == ExprNode::Kind::MatMul &&
+            IsFusableBias(*input.lhs, *input.rhs)) {
+          return EvalProduct(*input.lhs, input.rhs.get(), true);
+        }
+        if (input.rhs->kind == ExprNode::Kind::MatMul &&
+            IsFusableBias(*input.rhs, *input.lhs)) {
+          return EvalProduct(*input.rhs, input.lhs.get(), true);
+        }
+      }
+      Matrix value = Eval(input);
+      return Elementwise(value, value, 1);
+    }
+    }
+    return Matrix();
+  }
+
+  // Collects the operands of a chain of products, left to right.
+  static void Flatten(const ExprNode &node,
+                      std::vector<const ExprNode *> &operands) {
+    if (node.kind == ExprNode::Kind::MatMul) {
+      Flatten(*node.lhs, operands);
+      Flatten(*node.rhs, operands);
+    } else {
+      operands.push_back(&node);
+    }
+  }
+
+  Matrix EvalProduct(const ExprNode &product, const ExprNode *biasNode,
+                     bool relu) {
+    std::vector<const ExprNode *> operandNodes;
+    Flatten(product, operandNodes);
+    const size_t n = operandNodes.size();
+
+    std::vector<Matrix> operands;
+    std::vector<uint64_t> dims = {operandNodes[0]->rows};
+    for (const ExprNode *operand : operandNodes) {
+      operands.push_back(Eval(*operand));
+      dims.push_back(operand->cols);
+    }
+
+    // Matrix-chain order: cost[i][j] is the cheapest multiply-add count for
+    // operands i..j, split[i][j] where that product is split.
+    std::vector<std::vector<uint64_t>> cost(n, std::vector<uint64_t>(n, 0));
+    std::vector<std::vector<size_t>> split(n, std::vector<size_t>(n, 0));
+    for (size_t length = 2; length <= n; ++length) {
+      for (size_t i = 0; i + length - 1 < n; ++i) {
+        const size_t j = i + length - 1;
+        cost[i][j] = std::numeric_limits<uint64_t>::max();
+        for (size_t k = i; k < j; ++k) {
+          const uint64_t c = cost[i][k] + cost[k + 1][j] +
+                             dims[i] * dims[k + 1] * dims[j + 1];
+          if (c < cost[i][j]) {
+            cost[i][j] = c;
+            split[i][j] = k;
+          }
+        }
+      }
+    }
+
+    GemmEpilogue epilogue{.relu = relu};
+    Matrix bias;
+    if (biasNode != nullptr) {
+      bias = Eval(*biasNode);
+      epilogue.bias = biasNode->rows == 1 && product.rows != 1
+                          ? GemmEpilogue::Bias::Row
+                          : GemmEpilogue::Bias::Matrix;
+    }
+
+    plan_ << "product " << Parenthesize(split, 0, n - 1) << " ("
+          << cost[0][n - 1] << " multiply-adds)";
+    if (epilogue.bias != GemmEpilogue::Bias::None) {
+      plan_ << " + fused "
+            << (epilogue.bias == GemmEpilogue::Bias::Row ? "row " : "")
+            << "bias";
+    }
+    if (relu) {
+      plan_ << " + fused relu";
+    }
+    plan_ << "\n";
+
+    return Multiply(operands, split, 0, n - 1, epilogue,
+                    biasNode != nullptr ? &bias : nullptr);
+  }
+
+  std::string Parenthesize(const std::vector<std::vector<size_t>> &split,
+                           size_t i, size_t j) const {
+    if (i == j) {
+      return "M" + std::to_string(i);
+    }
+    return "(" + Parenthesize(split, i, split[i][j]) + " * " +
+           Parenthesize(split, split[i][j] + 1, j) + ")";
+  }
+
+  // Only the outermost product of the chain gets the epilogue.
+  Matrix Multiply(const std::vector<Matrix> &operands,
+                  const std::vector<std::vector<size_t>> &split, size_t i,
+                  size_t j, const GemmEpilogue &epilogue, const Matrix *bias) {
+    if (i == j) {
+      return operands[i];
+    }
+    const size_t k = split[i][j];
+    const Matrix lhs = Multiply(operands, split, i, k, GemmEpilogue{}, nullptr);
+    const Matrix rhs =
+        Multiply(operands, split, k + 1, j, GemmEpilogue{}, nullptr);
+
+    Matrix result = context_.Allocate(lhs.rows(), rhs.cols());
+    const BufferBinding biasBinding =
+        bias != nullptr ? bias->binding() : BufferBinding{};
+    context_.GetGemm(epilogue).Dispatch(
+        passEncoder_, lhs.binding(), rhs.binding(), result.binding(),
+        lhs.rows(), rhs.cols(), lhs.cols(),
+        bias != nullptr ? &biasBinding : nullptr);
+    return result;
+  }
+
+  Matrix Elementwise(const Matrix &lhs, const Matrix &rhs, uint32_t op) {
+    Matrix result = context_.Allocate(lhs.rows(), lhs.cols());
+    const ElementwiseParams params{
+        .count = lhs.rows() * lhs.cols(),
+        .cols = lhs.cols(),
+        .op = op,
+        .broadcastRow = op == 0 && rhs.rows() == 1 && lhs.rows() != 1,
+    };
+    plan_ << (op == 0 ? "elementwise add\n" : "elementwise relu\n");
+
+    wgpu::BufferDescriptor paramsDesc{
+        .usage = wgpu::BufferUsage::Uniform,
+        .size = sizeof(params),
+        .mappedAtCreation = true,
+    };
+    TrackedBuffer paramsBuffer =
+        context_.allocator_.CreateBuffer(paramsDesc);
+    std::memcpy(paramsBuffer.Get().GetMappedRange(), &params, sizeof(params));
+    paramsBuffer.Get().Unmap();
+
+    const wgpu::BindGroupEntry entries[4] = {
+        BindingEntry(0, {.buffer = lhs.binding().buffer}),
+        BindingEntry(1, {.buffer = rhs.binding().buffer}),
+        BindingEntry(2, {.buffer = result.binding().buffer}),
+        BindingEntry(3, {.buffer = paramsBuffer.Get()})};
+    wgpu::BindGroup bindGroup = MakeBindGroup(
+        context_.device_, context_.elementwisePipeline_, entries, 4);
+
+    passEncoder_.SetPipeline(context_.elementwisePipeline_);
+    passEncoder_.SetBindGroup(0, bindGroup);
+    DispatchLinear(passEncoder_, (params.count + 255) / 256);
+    return result;
+  }
+
+  MatrixContext &context_;
+  wgpu::CommandEncoder commandEncoder_;
+  wgpu::ComputePassEncoder passEncoder_;
+  std::ostringstream plan_;
+};
+
+MatrixContext::MatrixContext(wgpu::Instance instance, wgpu::Device device)
+    : instance_(std::move(instance)), device_(std::move(device)),
+      allocator_(device_),
+      elementwisePipeline_(CreatePipeline(device_, elementwiseShaderCode)) {}
+
+Matrix MatrixContext::Allocate(uint32_t rows, uint32_t cols) {
+  wgpu::BufferDescriptor descriptor{
+      .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc |
+               wgpu::BufferUsage::CopyDst,
+      .size = uint64_t(rows) * cols * sizeof(float),
+  };
+  return Matrix(std::make_shared<Matrix::Storage>(Matrix::Storage{
+      .context = this,
+      .buffer = allocator_.CreateBuffer(descriptor),
+      .rows = rows,
+      .cols = cols,
+  }));
+}
+
+Matrix MatrixContext::Upload(uint32_t rows, uint32_t cols,
+                             const std::vector<float> &data) {
+  if (data.size() != size_t(rows) * cols) {
+    throw std::invalid_argument("Upload: data size does not match shape");
+  }
+  Matrix matrix = Allocate(rows, cols);
+  device_.GetQueue().WriteBuffer(matrix.binding().buffer, 0, data.data(),
+                                 data.size() * sizeof(float));
+  return matrix;
+}
+
+Matrix MatrixContext::Evaluate(const std::shared_ptr<const ExprNode> &node) {
+  ExprEvaluator evaluator(*this);
+  Matrix result = evaluator.Run(*node);
+  lastPlan_ = evaluator.Plan();
+  return result;
+}
+
+GemmPipeline &MatrixContext::GetGemm(const GemmEpilogue &epilogue) {
+  std::unique_ptr<GemmPipeline> &gemm =
+      gemms_[{int(epilogue.bias), epilogue.relu}];
+  if (!gemm) {
+    gemm = std::make_unique<GemmPipeline>(device_, allocator_,
+                                          GemmSourceWithEpilogue(epilogue));
+  }
+  return *gemm;
+}
+
+std::vector<float> MatrixContext::Read(const Matrix &matrix) {
+  return ReadBack<float>(instance_, allocator_, matrix.binding(),
+                         uint64_t(matrix.rows()) * matrix.cols() *
+                             sizeof(float));
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmPipeline.h"
+#include "TrackedAllocator.h"
+
+// Lazy matrix expressions on the device.
+//
+//   MatrixContext context(instance, device);
+//   Matrix A = context.Upload(m, k, a);
+//   ...
+//   auto D = relu(A * B * C + E);   // nothing runs yet
+//   Matrix result = D.eval();       // one submission, stays on the device
+//   std::vector<float> host = result.read();
+//
+// Operators only build a typed expression tree. eval() turns it into a graph
+// and records the whole graph into one command buffer:
+//   - chains of products are reordered with the classic matrix-chain dynamic
+//     program, so A * B * C picks (A * B) * C or A * (B * C) by FLOPs;
+//   - a bias add (M x N or 1 x N) and/or relu on top of a product is fused
+//     into the GEMM's epilogue instead of running as a separate pass;
+//   - intermediates are device buffers that are never read back.
+//
+// A context and its matrices are not thread-safe; use GemmRuntime to share a
+// device between threads.
+
+class Matrix;
+class MatrixContext;
+struct ExprNode;
+
+template <typename Derived> class MatrixExpr {
+public:
+  const Derived &derived() const { return static_cast<const Derived &>(*this); }
+  uint32_t rows() const { return derived().rows(); }
+  uint32_t cols() const { return derived().cols(); }
+
+  // Evaluates the expression on the device.
+  Matrix eval() const;
+  // eval() followed by a readback.
+  std::vector<float> read() const;
+};
+
+// Device-resident, immutable matrix in row-major order. Copies share the
+// same buffer.
+class Matrix : public MatrixExpr<Matrix> {
+public:
+  Matrix() = default;
+
+  uint32_t rows() const { return storage_->rows; }
+  uint32_t cols() const { return storage_->cols; }
+
+  Matrix eval() const { return *this; }
+  std::vector<float> read() const;
+
+  BufferBinding binding() const { return {.buffer = storage_->buffer.Get()}; }
+  MatrixContext &context() const { return *storage_->context; }
+  std::shared_ptr<const ExprNode> node() const;
+
+private:
+  friend class MatrixContext;
+
+  struct Storage {
+    MatrixContext *context;
+    TrackedBuffer buffer;
+    uint32_t rows;
+    uint32_t cols;
+  };
+
+  explicit Matrix(std::shared_ptr<Storage> storage)
+      : storage_(std::move(storage)) {}
+
+  std::shared_ptr<Storage> storage_;
+};
+
+// Runtime form of an expression, built by eval().
+struct ExprNode {
+  enum class Kind { Leaf, MatMul, Add, Relu };
+
+  Kind kind;
+  uint32_t rows;
+  uint32_t cols;
+  std::shared_ptr<const ExprNode> lhs;
+  std::shared_ptr<const ExprNode> rhs;
+  Matrix leaf; // Kind::Leaf only
+};
+
+template <typename L, typename R>
+class MatMulExpr : public MatrixExpr<MatMulExpr<L, R>> {
+public:
+  MatMulExpr(const L &lhs, const R &rhs) : lhs_(lhs), rhs_(rhs) {
+    if (lhs.cols() != rhs.rows()) {
+      throw std::invalid_argument("MatMul: inner dimensions differ");
+    }
+  }
+  uint32_t rows() const { return lhs_.rows(); }
+  uint32_t cols() const { return rhs_.cols(); }
+  MatrixContext &context() const { return lhs_.context(); }
+  std::shared_ptr<const ExprNode> node() const {
+    return std::make_shared<ExprNode>(ExprNode{ExprNode::Kind::MatMul, rows(),
+                                               cols(), lhs_.node(),
+                                               rhs_.node()});
+  }
+
+private:
+  L lhs_;
+  R rhs_;
+};
+
+// Elementwise sum. `rhs` may also be a 1 x N row broadcast over the rows.
+template <typename L, typename R>
+class AddExpr : public MatrixExpr<AddExpr<L, R>> {
+public:
+  AddExpr(const L &lhs, const R &rhs) : lhs_(lhs), rhs_(rhs) {
+    if (lhs.cols() != rhs.cols() ||
+        (lhs.rows() != rhs.rows() && rhs.rows() != 1)) {
+      throw std::invalid_argument("Add: shapes differ");
+    }
+  }
+  uint32_t rows() const { return lhs_.rows(); }
+  uint32_t cols() const { return lhs_.cols(); }
+  MatrixContext &context() const { return lhs_.context(); }
+  std::shared_ptr<const ExprNode> node() const {
+    return std::make_shared<ExprNode>(ExprNode{
+        ExprNode::Kind::Add, rows(), cols(), lhs_.node(), rhs_.node()});
+  }
+
+private:
+  L lhs_;
+  R rhs_;
+};
+
+template <typename E> class ReluExpr : public MatrixExpr<ReluExpr<E>> {
+public:
+  explicit ReluExpr(const E &input) : input_(input) {}
+  uint32_t rows() const { return input_.rows(); }
+  uint32_t cols() const { return input_.cols(); }
+  MatrixContext &context() const { return input_.context(); }
+  std::shared_ptr<const ExprNode> node() const {
+    return std::make_shared<ExprNode>(
+        ExprNode{ExprNode::Kind::Relu, rows(), cols(), input_.node()});
+  }
+
+private:
+  E input_;
+};
+
+template <typename L, typename R>
+MatMulExpr<L, R> operator*(const MatrixExpr<L> &lhs,
+                           const MatrixExpr<R> &rhs) {
+  return MatMulExpr<L, R>(lhs.derived(), rhs.derived());
+}
+
+template <typename L, typename R>
+AddExpr<L, R> operator+(const MatrixExpr<L> &lhs, const MatrixExpr<R> &rhs) {
+  return AddExpr<L, R>(lhs.derived(), rhs.derived());
+}
+
+template <typename E> ReluExpr<E> relu(const MatrixExpr<E> &input) {
+  return ReluExpr<E>(input.derived());
+}
+
+class MatrixContext {
+public:
+  MatrixContext(wgpu::Instance instance, wgpu::Device device);
+
+  Matrix Upload(uint32_t rows, uint32_t cols, const std::vector<float> &data);
+
+  // Records and submits the whole graph, returns its (device) result.
+  Matrix Evaluate(const std::shared_ptr<const ExprNode> &node);
+
+  // Human-readable description of the last Evaluate(): product order and
+  // fused epilogues.
+  const std::string &LastPlan() const { return lastPlan_; }
+
+  TrackedAllocator &GetAllocator() { return allocator_; }
+
+private:
+  friend class Matrix;
+  friend class ExprEvaluator;
+
+  Matrix Allocate(uint32_t rows, uint32_t cols);
+  std::vector<float> Read(const Matrix &matrix);
+  GemmPipeline &GetGemm(const GemmEpilogue &epilogue);
+
+  wgpu::Instance instance_;
+  wgpu::Device device_;
+  TrackedAllocator allocator_;
+  std::map<std::pair<int, bool>, std::unique_ptr<GemmPipeline>> gemms_;
+  wgpu::ComputePipeline elementwisePipeline_;
+  std::string lastPlan_;
+};
+
+inline std::shared_ptr<const ExprNode> Matrix::node() const {
+  return std::make_shared<ExprNode>(
+      ExprNode{ExprNode::Kind::Leaf, rows(), cols(), nullptr, nullptr, *this});
+}
+
+inline std::vector<float> Matrix::read() const {
+  return storage_->context->Read(*this);
+}
+
+template <typename Derived> Matrix MatrixExpr<Derived>::eval() const {
+  return derived().context().Evaluate(derived().node());
+}
+
+template <typename Derived>
+std::vector<float> MatrixExpr<Derived>::read() const {
+  return eval().read();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+
+// Intrusive multi-producer single-consumer queue (Dmitry Vyukov's design).
+// Any number of threads may Push concurrently without locks; only one thread
+// may Pop. Push is a single atomic exchange, so producers never wait on each
+// other or on the consumer.
+struct MpscNode {
+  std::atomic<MpscNode *> next{nullptr};
+};
+
+template <typename T> class MpscQueue {
+public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  void Push(T *item) { PushNode(static_cast<MpscNode *>(item)); }
+
+  // Returns nullptr when the queue is empty, or when a producer is halfway
+  // through a Push. Callers should simply try again later in that case.
+  T *Pop() {
+    MpscNode *tail = tail_;
+    MpscNode *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T *>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    PushNode(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T *>(tail);
+    }
+    return nullptr;
+  }
+
+private:
+  void PushNode(MpscNode *node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    MpscNode *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  MpscNode stub_;
+  std::atomic<MpscNode *> head_;  // producers push here
+  MpscNode *tail_;                // consumer pops from here
+};
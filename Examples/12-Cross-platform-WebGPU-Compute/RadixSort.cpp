@@ -0,0 +1,249 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "DeviceHelpers.h"
+
+namespace {
+
+constexpr uint32_t kDigits = 1u << kRadixBits;
+
+// Host-side mirror of the SortParams uniform.
+struct SortParams {
+  uint32_t count;
+  uint32_t tiles;
+  uint32_t shift;
+  uint32_t pad;
+};
+
+// 256 invocations x 4 keys = kScanTileSize, so the digit table has one entry
+// per (digit, scan tile).
+const char sortCommon[] = R"(
+    struct SortParams {
+        count : u32,
+        tiles : u32,
+        shift : u32,
+    };
+
+    @group(0) @binding(0) var<storage, read> keysIn : array<u32>;
+    @group(0) @binding(3) var<uniform> params : SortParams;
+
+    const WG : u32 = 256u;
+    const ITEMS : u32 = 4u;
+    const DIGITS : u32 = 16u;
+
+    fn digitOf(key : u32) -> u32 {
+        return (key >> params.shift) & (DIGITS - 1u);
+    }
+)";
+
+const char histogramShader[] = R"(
+    @group(0) @binding(1) var<storage, read_write> digitCounts : array<u32>;
+
+    var<workgroup> histogram : array<atomic<u32>, DIGITS>;
+
+    @compute @workgroup_size(WG)
+    fn main(@builtin(workgroup_id) groupId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>,
+            @builtin(local_invocation_index) lid : u32) {
+        let tile = groupId.x + groupId.y * groups.x;
+        if (tile >= params.tiles) {
+            return;
+        }
+        for (var i = 0u; i < ITEMS; i++) {
+            let index = (tile * WG + lid) * ITEMS + i;
+            if (index < params.count) {
+                atomicAdd(&histogram[digitOf(keysIn[index])], 1u);
+            }
+        }
+        workgroupBarrier();
+        if (lid < DIGITS) {
+            digitCounts[lid * params.tiles + tile] = atomicLoad(&histogram[lid]);
+        }
+    }
+)";
+
+// Per-invocation digit counts are packed 16 bits per digit into 8 words; a
+// tile holds at most 1024 keys, so no lane can carry into the next.
+std::string ScatterShader(bool withValues) {
+  return std::string(R"(
+    @group(0) @binding(1) var<storage, read_write> keysOut : array<u32>;
+    @group(0) @binding(2) var<storage, read> digitOffsets : array<u32>;
+)") + (withValues ? R"(
+    @group(0) @binding(4) var<storage, read> valuesIn : array<u32>;
+    @group(0) @binding(5) var<storage, read_write> valuesOut : array<u32>;
+)"
+                  : "") +
+         R"(
+    const WORDS : u32 = DIGITS / 2u;
+
+    var<workgroup> counters : array<array<u32, WORDS>, WG>;
+
+    fn laneShift(digit : u32) -> u32 {
+        return (digit % 2u) * 16u;
+    }
+
+    @compute @workgroup_size(WG)
+    fn main(@builtin(workgroup_id) groupId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>,
+            @builtin(local_invocation_index) lid : u32) {
+        let tile = groupId.x + groupId.y * groups.x;
+        if (tile >= params.tiles) {
+            return;
+        }
+
+        var keys : array<u32, ITEMS>;
+        var ownCounts : array<u32, WORDS>;
+        for (var i = 0u; i < ITEMS; i++) {
+            let index = (tile * WG + lid) * ITEMS + i;
+            if (index < params.count) {
+                keys[i] = keysIn[index];
+                let digit = digitOf(keys[i]);
+                ownCounts[digit / 2u] += 1u << laneShift(digit);
+            }
+        }
+        counters[lid] = ownCounts;
+        workgroupBarrier();
+
+        // Inclusive Hillis-Steele scan of the packed counters.
+        for (var offset = 1u; offset < WG; offset *= 2u) {
+            var addend : array<u32, WORDS>;
+            if (lid >= offset) {
+                addend = counters[lid - offset];
+            }
+            workgroupBarrier();
+            for (var w = 0u; w < WORDS; w++) {
+                counters[lid][w] += addend[w];
+            }
+            workgroupBarrier();
+        }
+
+        // Exclusive prefix: keys with the same digit in earlier invocations,
+        // then earlier keys of this invocation.
+        var before = counters[lid];
+        for (var w = 0u; w < WORDS; w++) {
+            before[w] -= ownCounts[w];
+        }
+        for (var i = 0u; i < ITEMS; i++) {
+            let index = (tile * WG + lid) * ITEMS + i;
+            if (index < params.count) {
+                let digit = digitOf(keys[i]);
+                let rank = (before[digit / 2u] >> laneShift(digit)) & 0xFFFFu;
+                let destination = digitOffsets[digit * params.tiles + tile] + rank;
+                keysOut[destination] = keys[i];
+)" + (withValues ? R"(
+                valuesOut[destination] = valuesIn[index];
+)"
+                 : "") +
+         R"(
+                before[digit / 2u] += 1u << laneShift(digit);
+            }
+        }
+    }
+)";
+}
+
+uint32_t TileCount(uint32_t count) {
+  if (count == 0) {
+    throw std::invalid_argument("RadixSort: empty input");
+  }
+  return (count + kScanTileSize - 1) / kScanTileSize;
+}
+
+} // namespace
+
+RadixSort::RadixSort(const wgpu::Device &device, TrackedAllocator &allocator,
+                     uint32_t count, bool withValues)
+    : device_(device), count_(count), tiles_(TileCount(count)),
+      withValues_(withValues),
+      scan_(device, allocator, kDigits * TileCount(count)) {
+  wgpu::BufferDescriptor tempDesc{
+      .usage = wgpu::BufferUsage::Storage,
+      .size = uint64_t(count) * sizeof(uint32_t),
+  };
+  keysTemp_ = allocator.CreateBuffer(tempDesc, BufferCategory::Intermediate);
+  if (withValues) {
+    valuesTemp_ = allocator.CreateBuffer(tempDesc, BufferCategory::Intermediate);
+  }
+  wgpu::BufferDescriptor tableDesc{
+      .usage = wgpu::BufferUsage::Storage,
+      .size = uint64_t(kDigits) * tiles_ * sizeof(uint32_t),
+  };
+  digitCounts_ = allocator.CreateBuffer(tableDesc, BufferCategory::Intermediate);
+  digitOffsets_ =
+      allocator.CreateBuffer(tableDesc, BufferCategory::Intermediate);
+
+  for (uint32_t shift = 0; shift < 32; shift += kRadixBits) {
+    const SortParams params{.count = count, .tiles = tiles_, .shift = shift};
+    wgpu::BufferDescriptor paramsDesc{
+        .usage = wgpu::BufferUsage::Uniform,
+        .size = sizeof(params),
+        .mappedAtCreation = true,
+    };
+    TrackedBuffer buffer = allocator.CreateBuffer(paramsDesc);
+    std::memcpy(buffer.Get().GetMappedRange(), &params, sizeof(params));
+    buffer.Get().Unmap();
+    params_.push_back(std::move(buffer));
+  }
+
+  histogramPipeline_ =
+      CreatePipeline(device_, std::string(sortCommon) + histogramShader);
+  scatterPipeline_ =
+      CreatePipeline(device_, std::string(sortCommon) + ScatterShader(withValues));
+}
+
+void RadixSort::Encode(const wgpu::CommandEncoder &encoder,
+                       const BufferBinding &keys, const BufferBinding *values) {
+  if ((values != nullptr) != withValues_) {
+    throw std::invalid_argument("RadixSort: values do not match the sorter");
+  }
+
+  const uint64_t bytes = uint64_t(count_) * sizeof(uint32_t);
+  const BufferBinding keyBuffers[2] = {
+      {.buffer = keys.buffer, .offset = keys.offset, .size = bytes},
+      {.buffer = keysTemp_.Get(), .size = bytes}};
+  BufferBinding valueBuffers[2] = {};
+  if (withValues_) {
+    valueBuffers[0] = {
+        .buffer = values->buffer, .offset = values->offset, .size = bytes};
+    valueBuffers[1] = {.buffer = valuesTemp_.Get(), .size = bytes};
+  }
+  const BufferBinding counts{.buffer = digitCounts_.Get()};
+  const BufferBinding offsets{.buffer = digitOffsets_.Get()};
+
+  wgpu::ComputePassEncoder passEncoder = encoder.BeginComputePass();
+  for (size_t pass = 0; pass < params_.size(); ++pass) {
+    const BufferBinding &keysIn = keyBuffers[pass % 2];
+    const BufferBinding &keysOut = keyBuffers[1 - pass % 2];
+    const BufferBinding params{.buffer = params_[pass].Get()};
+
+    const wgpu::BindGroupEntry histogramEntries[3] = {
+        BindingEntry(0, keysIn), BindingEntry(1, counts),
+        BindingEntry(3, params)};
+    passEncoder.SetPipeline(histogramPipeline_);
+    passEncoder.SetBindGroup(
+        0, MakeBindGroup(device_, histogramPipeline_, histogramEntries, 3));
+    DispatchLinear(passEncoder, tiles_);
+
+    scan_.Record(passEncoder, counts, offsets, ScanKind::Exclusive);
+
+    wgpu::BindGroupEntry scatterEntries[6] = {
+        BindingEntry(0, keysIn), BindingEntry(1, keysOut),
+        BindingEntry(2, offsets), BindingEntry(3, params)};
+    size_t scatterEntryCount = 4;
+    if (withValues_) {
+      scatterEntries[4] = BindingEntry(4, valueBuffers[pass % 2]);
+      scatterEntries[5] = BindingEntry(5, valueBuffers[1 - pass % 2]);
+      scatterEntryCount = 6;
+    }
+    passEncoder.SetPipeline(scatterPipeline_);
+    passEncoder.SetBindGroup(0, MakeBindGroup(device_, scatterPipeline_,
+                                              scatterEntries,
+                                              scatterEntryCount));
+    DispatchLinear(passEncoder, tiles_);
+  }
+  passEncoder.End();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmPipeline.h"
+#include "Scan.h"
+#include "TrackedAllocator.h"
+
+// Stable LSD radix sort of u32 keys, optionally carrying u32 values.
+//
+// Eight passes of 4 bits. Each pass:
+//   1. counts the digits of every tile of kScanTileSize keys into a
+//      digit-major table (digit * tiles + tile),
+//   2. exclusive-scans that table with Scan, giving each (digit, tile) its
+//      first output position,
+//   3. re-reads each tile, ranks every key among the equal digits before it
+//      in the tile (a workgroup scan of packed per-digit counters) and
+//      scatters it to position + rank.
+// Keys (and values) ping-pong through a temporary buffer; after the even
+// number of passes the sorted result is back in the caller's buffers.
+
+constexpr uint32_t kRadixBits = 4;
+
+class RadixSort {
+public:
+  RadixSort(const wgpu::Device &device, TrackedAllocator &allocator,
+            uint32_t count, bool withValues = false);
+
+  // Sorts `count` keys ascending, in place. `values` must be given exactly
+  // when the sorter was created `withValues`.
+  void Encode(const wgpu::CommandEncoder &encoder, const BufferBinding &keys,
+              const BufferBinding *values = nullptr);
+
+private:
+  wgpu::Device device_;
+  uint32_t count_;
+  uint32_t tiles_;
+  bool withValues_;
+
+  TrackedBuffer keysTemp_;
+  TrackedBuffer valuesTemp_;
+  TrackedBuffer digitCounts_;
+  TrackedBuffer digitOffsets_;
+  std::vector<TrackedBuffer> params_; // one per pass
+  Scan scan_;
+
+  wgpu::ComputePipeline histogramPipeline_;
+  wgpu::ComputePipeline scatterPipeline_;
+};
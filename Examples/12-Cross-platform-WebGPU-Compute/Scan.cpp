@@ -0,0 +1,220 @@
+#include "Scan.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "DeviceHelpers.h"
+
+namespace {
+
+// Host-side mirror of the ScanParams uniform.
+struct ScanParams {
+  uint32_t count;
+  uint32_t tiles;
+  uint32_t pad[2];
+};
+
+// 256 invocations x 4 values = kScanTileSize.
+const char scanCommon[] = R"(
+    struct ScanParams {
+        count : u32,
+        tiles : u32,
+    };
+
+    @group(0) @binding(0) var<storage, read> values : array<u32>;
+    @group(0) @binding(3) var<uniform> params : ScanParams;
+
+    const WG : u32 = 256u;
+    const ITEMS : u32 = 4u;
+
+    var<workgroup> partial : array<u32, WG>;
+
+    fn loadItems(tile : u32, lid : u32) -> array<u32, ITEMS> {
+        var items : array<u32, ITEMS>;
+        for (var i = 0u; i < ITEMS; i++) {
+            let index = (tile * WG + lid) * ITEMS + i;
+            if (index < params.count) {
+                items[i] = values[index];
+            }
+        }
+        return items;
+    }
+)";
+
+const char reduceShader[] = R"(
+    @group(0) @binding(1) var<storage, read_write> sums : array<u32>;
+
+    @compute @workgroup_size(WG)
+    fn main(@builtin(workgroup_id) groupId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>,
+            @builtin(local_invocation_index) lid : u32) {
+        let tile = groupId.x + groupId.y * groups.x;
+        if (tile >= params.tiles) {
+            return;
+        }
+        let items = loadItems(tile, lid);
+        partial[lid] = items[0] + items[1] + items[2] + items[3];
+        workgroupBarrier();
+        for (var stride = WG / 2u; stride > 0u; stride /= 2u) {
+            if (lid < stride) {
+                partial[lid] += partial[lid + stride];
+            }
+            workgroupBarrier();
+        }
+        if (lid == 0u) {
+            sums[tile] = partial[0];
+        }
+    }
+)";
+
+std::string ScanShader(ScanKind kind) {
+  const bool inclusive = kind == ScanKind::Inclusive;
+  return std::string(R"(
+    @group(0) @binding(1) var<storage, read_write> result : array<u32>;
+    @group(0) @binding(2) var<storage, read> tileOffsets : array<u32>;
+
+    @compute @workgroup_size(WG)
+    fn main(@builtin(workgroup_id) groupId : vec3<u32>,
+            @builtin(num_workgroups) groups : vec3<u32>,
+            @builtin(local_invocation_index) lid : u32) {
+        let tile = groupId.x + groupId.y * groups.x;
+        if (tile >= params.tiles) {
+            return;
+        }
+        let items = loadItems(tile, lid);
+        partial[lid] = items[0] + items[1] + items[2] + items[3];
+        workgroupBarrier();
+
+        // Inclusive Hillis-Steele scan of the per-invocation sums.
+        for (var offset = 1u; offset < WG; offset *= 2u) {
+            var addend = 0u;
+            if (lid >= offset) {
+                addend = partial[lid - offset];
+            }
+            workgroupBarrier();
+            partial[lid] += addend;
+            workgroupBarrier();
+        }
+
+        var running = tileOffsets[tile];
+        if (lid > 0u) {
+            running += partial[lid - 1u];
+        }
+        for (var i = 0u; i < ITEMS; i++) {
+            let index = (tile * WG + lid) * ITEMS + i;
+)") + (inclusive ? R"(
+            running += items[i];
+            if (index < params.count) {
+                result[index] = running;
+            }
+)"
+                 : R"(
+            if (index < params.count) {
+                result[index] = running;
+            }
+            running += items[i];
+)") + R"(
+        }
+    }
+)";
+}
+
+} // namespace
+
+Scan::Scan(const wgpu::Device &device, TrackedAllocator &allocator,
+           uint32_t count)
+    : device_(device), count_(count) {
+  if (count == 0) {
+    throw std::invalid_argument("Scan: empty input");
+  }
+
+  // One level per round of tile sums, down to a single tile.
+  for (uint32_t levelCount = count;;) {
+    const uint32_t tiles = (levelCount + kScanTileSize - 1) / kScanTileSize;
+    const ScanParams params{.count = levelCount, .tiles = tiles};
+    wgpu::BufferDescriptor paramsDesc{
+        .usage = wgpu::BufferUsage::Uniform,
+        .size = sizeof(params),
+        .mappedAtCreation = true,
+    };
+    Level level{.count = levelCount, .tiles = tiles};
+    level.params = allocator.CreateBuffer(paramsDesc);
+    std::memcpy(level.params.Get().GetMappedRange(), &params, sizeof(params));
+    level.params.Get().Unmap();
+    if (tiles > 1) {
+      wgpu::BufferDescriptor sumsDesc{
+          .usage = wgpu::BufferUsage::Storage,
+          .size = tiles * sizeof(uint32_t),
+      };
+      level.sums = allocator.CreateBuffer(sumsDesc, BufferCategory::Intermediate);
+      level.offsets =
+          allocator.CreateBuffer(sumsDesc, BufferCategory::Intermediate);
+    }
+    levels_.push_back(std::move(level));
+    if (tiles == 1) {
+      break;
+    }
+    levelCount = tiles;
+  }
+
+  // New buffers are zero-initialized.
+  wgpu::BufferDescriptor zeroDesc{
+      .usage = wgpu::BufferUsage::Storage,
+      .size = sizeof(uint32_t),
+  };
+  zero_ = allocator.CreateBuffer(zeroDesc, BufferCategory::Intermediate);
+
+  reducePipeline_ =
+      CreatePipeline(device_, std::string(scanCommon) + reduceShader);
+  for (ScanKind kind : {ScanKind::Exclusive, ScanKind::Inclusive}) {
+    scanPipelines_[int(kind)] =
+        CreatePipeline(device_, std::string(scanCommon) + ScanShader(kind));
+  }
+}
+
+void Scan::Encode(const wgpu::CommandEncoder &encoder,
+                  const BufferBinding &input, const BufferBinding &output,
+                  ScanKind kind) {
+  wgpu::ComputePassEncoder passEncoder = encoder.BeginComputePass();
+  Record(passEncoder, input, output, kind);
+  passEncoder.End();
+}
+
+void Scan::Record(const wgpu::ComputePassEncoder &pass,
+                  const BufferBinding &input, const BufferBinding &output,
+                  ScanKind kind) {
+  RecordLevel(pass, 0, input, output, kind);
+}
+
+void Scan::RecordLevel(const wgpu::ComputePassEncoder &pass, size_t level,
+                       const BufferBinding &input, const BufferBinding &output,
+                       ScanKind kind) {
+  const Level &current = levels_[level];
+  const BufferBinding params{.buffer = current.params.Get()};
+  BufferBinding tileOffsets{.buffer = zero_.Get()};
+
+  if (current.tiles > 1) {
+    const BufferBinding sums{.buffer = current.sums.Get()};
+    const BufferBinding offsets{.buffer = current.offsets.Get()};
+    const wgpu::BindGroupEntry entries[3] = {BindingEntry(0, input),
+                                             BindingEntry(1, sums),
+                                             BindingEntry(3, params)};
+    pass.SetPipeline(reducePipeline_);
+    pass.SetBindGroup(0, MakeBindGroup(device_, reducePipeline_, entries, 3));
+    DispatchLinear(pass, current.tiles);
+
+    RecordLevel(pass, level + 1, sums, offsets, ScanKind::Exclusive);
+    tileOffsets = offsets;
+  }
+
+  const wgpu::ComputePipeline &pipeline = scanPipelines_[int(kind)];
+  const wgpu::BindGroupEntry entries[4] = {BindingEntry(0, input),
+                                           BindingEntry(1, output),
+                                           BindingEntry(2, tileOffsets),
+                                           BindingEntry(3, params)};
+  pass.SetPipeline(pipeline);
+  pass.SetBindGroup(0, MakeBindGroup(device_, pipeline, entries, 4));
+  DispatchLinear(pass, current.tiles);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "GemmPipeline.h"
+#include "TrackedAllocator.h"
+
+// Device-wide prefix sum over u32 values, reduce-then-scan.
+//
+// The input is split into tiles of kScanTileSize values, one workgroup each.
+// A reduce pass writes one sum per tile; those sums are scanned the same way
+// (recursively, until a single tile is left); a final pass scans each tile in
+// workgroup memory and adds its tile's offset. That is about 3 reads and 1
+// write per element, and unlike decoupled look-back it never spins waiting on
+// another workgroup, which WebGPU does not guarantee forward progress for.
+
+enum class ScanKind { Exclusive, Inclusive };
+
+constexpr uint32_t kScanTileSize = 1024;
+
+class Scan {
+public:
+  Scan(const wgpu::Device &device, TrackedAllocator &allocator,
+       uint32_t count);
+
+  // Scans `count` values from `input` into `output`; the buffers must not
+  // overlap.
+  void Encode(const wgpu::CommandEncoder &encoder, const BufferBinding &input,
+              const BufferBinding &output, ScanKind kind);
+  // Same, recorded into an existing compute pass.
+  void Record(const wgpu::ComputePassEncoder &pass, const BufferBinding &input,
+              const BufferBinding &output, ScanKind kind);
+
+  uint32_t GetCount() const { return count_; }
+
+private:
+  // Tile sums of one level and their exclusive scan.
+  struct Level {
+    uint32_t count;
+    uint32_t tiles;
+    TrackedBuffer params;
+    TrackedBuffer sums;
+    TrackedBuffer offsets;
+  };
+
+  void RecordLevel(const wgpu::ComputePassEncoder &pass, size_t level,
+                   const BufferBinding &input, const BufferBinding &output,
+                   ScanKind kind);
+
+  wgpu::Device device_;
+  uint32_t count_;
+  std::vector<Level> levels_;
+  TrackedBuffer zero_; // tile offset of a single-tile level
+
+  wgpu::ComputePipeline reducePipeline_;
+  wgpu::ComputePipeline scanPipelines_[2]; // indexed by ScanKind
+};
@@ -0,0 +1,146 @@
+#include "TrackedAllocator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+const char *BufferCategoryName(BufferCategory category) {
+  switch (category) {
+  case BufferCategory::Storage:
+    return "storage";
+  case BufferCategory::Intermediate:
+    return "intermediate";
+  case BufferCategory::Uniform:
+    return "uniform";
+  case BufferCategory::Readback:
+    return "readback";
+  case BufferCategory::Upload:
+    return "upload";
+  case BufferCategory::Other:
+  case BufferCategory::Count:
+    break;
+  }
+  return "other";
+}
+
+TrackedBuffer::TrackedBuffer(TrackedAllocator *allocator, wgpu::Buffer buffer,
+                             BufferCategory category, uint64_t size)
+    : allocator_(allocator), buffer_(std::move(buffer)), category_(category),
+      size_(size) {}
+
+TrackedBuffer::TrackedBuffer(TrackedBuffer &&other) noexcept
+    : allocator_(std::exchange(other.allocator_, nullptr)),
+      buffer_(std::move(other.buffer_)), category_(other.category_),
+      size_(std::exchange(other.size_, 0)) {
+  other.buffer_ = nullptr;
+}
+
+TrackedBuffer &TrackedBuffer::operator=(TrackedBuffer &&other) noexcept {
+  if (this != &other) {
+    Reset();
+    allocator_ = std::exchange(other.allocator_, nullptr);
+    buffer_ = std::move(other.buffer_);
+    other.buffer_ = nullptr;
+    category_ = other.category_;
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+TrackedBuffer::~TrackedBuffer() { Reset(); }
+
+void TrackedBuffer::Reset() {
+  if (allocator_ != nullptr) {
+    allocator_->Release(category_, size_);
+  }
+  allocator_ = nullptr;
+  buffer_ = nullptr;
+  size_ = 0;
+}
+
+TrackedAllocator::TrackedAllocator(wgpu::Device device)
+    : device_(std::move(device)) {}
+
+BufferCategory TrackedAllocator::CategoryForUsage(wgpu::BufferUsage usage) {
+  if (usage & wgpu::BufferUsage::MapRead) {
+    return BufferCategory::Readback;
+  }
+  if (usage & wgpu::BufferUsage::MapWrite) {
+    return BufferCategory::Upload;
+  }
+  if (usage & wgpu::BufferUsage::Uniform) {
+    return BufferCategory::Uniform;
+  }
+  if (usage & wgpu::BufferUsage::Storage) {
+    return BufferCategory::Storage;
+  }
+  return BufferCategory::Other;
+}
+
+TrackedBuffer
+TrackedAllocator::CreateBuffer(const wgpu::BufferDescriptor &descriptor) {
+  return CreateBuffer(descriptor, CategoryForUsage(descriptor.usage));
+}
+
+TrackedBuffer
+TrackedAllocator::CreateBuffer(const wgpu::BufferDescriptor &descriptor,
+                               BufferCategory category) {
+  wgpu::Buffer buffer = device_.CreateBuffer(&descriptor);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Usage *usage : {&categories_[size_t(category)], &total_}) {
+      usage->liveBytes += descriptor.size;
+      usage->peakBytes = std::max(usage->peakBytes, usage->liveBytes);
+      ++usage->liveBuffers;
+      ++usage->allocations;
+    }
+  }
+  return TrackedBuffer(this, std::move(buffer), category, descriptor.size);
+}
+
+void TrackedAllocator::Release(BufferCategory category, uint64_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Usage *usage : {&categories_[size_t(category)], &total_}) {
+    usage->liveBytes -= size;
+    --usage->liveBuffers;
+  }
+}
+
+TrackedAllocator::Usage
+TrackedAllocator::GetUsage(BufferCategory category) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return categories_[size_t(category)];
+}
+
+TrackedAllocator::Usage TrackedAllocator::GetTotalUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_;
+}
+
+void TrackedAllocator::ResetPeaks() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Usage &usage : categories_) {
+    usage.peakBytes = usage.liveBytes;
+  }
+  total_.peakBytes = total_.liveBytes;
+}
+
+void TrackedAllocator::PrintReport(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto printRow = [&out](const char *name, const Usage &usage) {
+    out << std::left << std::setw(14) << name << std::right << std::setw(14)
+        << usage.liveBytes << std::setw(14) << usage.peakBytes
+        << std::setw(10) << usage.liveBuffers << std::setw(10)
+        << usage.allocations << "\n";
+  };
+
+  out << std::left << std::setw(14) << "category" << std::right
+      << std::setw(14) << "live bytes" << std::setw(14) << "peak bytes"
+      << std::setw(10) << "live" << std::setw(10) << "allocs" << "\n";
+  for (size_t i = 0; i < categories_.size(); ++i) {
+    if (categories_[i].allocations > 0) {
+      printRow(BufferCategoryName(BufferCategory(i)), categories_[i]);
+    }
+  }
+  printRow("total", total_);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <webgpu/webgpu_cpp.h>
+
+// Memory accounting for device buffers.
+//
+// TrackedAllocator wraps device.CreateBuffer and hands out TrackedBuffer
+// handles. Each handle counts towards the live bytes of its category until
+// it is destroyed (or moved from), and the allocator remembers the peak live
+// bytes per category and overall. Like any wgpu::Buffer, the memory itself is
+// returned to the driver once Dawn drops its last internal reference.
+
+enum class BufferCategory : uint32_t {
+  Storage,
+  Intermediate,
+  Uniform,
+  Readback,
+  Upload,
+  Other,
+  Count,
+};
+
+const char *BufferCategoryName(BufferCategory category);
+
+class TrackedAllocator;
+
+class TrackedBuffer {
+public:
+  TrackedBuffer() = default;
+  TrackedBuffer(TrackedBuffer &&other) noexcept;
+  TrackedBuffer &operator=(TrackedBuffer &&other) noexcept;
+  ~TrackedBuffer();
+
+  TrackedBuffer(const TrackedBuffer &) = delete;
+  TrackedBuffer &operator=(const TrackedBuffer &) = delete;
+
+  const wgpu::Buffer &Get() const { return buffer_; }
+  uint64_t GetSize() const { return size_; }
+  BufferCategory GetCategory() const { return category_; }
+  explicit operator bool() const { return bool(buffer_); }
+
+  // Stops tracking the buffer and drops this handle's reference.
+  void Reset();
+
+private:
+  friend class TrackedAllocator;
+  TrackedBuffer(TrackedAllocator *allocator, wgpu::Buffer buffer,
+                BufferCategory category, uint64_t size);
+
+  TrackedAllocator *allocator_ = nullptr;
+  wgpu::Buffer buffer_;
+  BufferCategory category_ = BufferCategory::Other;
+  uint64_t size_ = 0;
+};
+
+class TrackedAllocator {
+public:
+  struct Usage {
+    uint64_t liveBytes = 0;
+    uint64_t peakBytes = 0;
+    uint64_t liveBuffers = 0;
+    uint64_t allocations = 0;
+  };
+
+  explicit TrackedAllocator(wgpu::Device device);
+
+  // The category is derived from the usage flags when not given.
+  TrackedBuffer CreateBuffer(const wgpu::BufferDescriptor &descriptor);
+  TrackedBuffer CreateBuffer(const wgpu::BufferDescriptor &descriptor,
+                             BufferCategory category);
+
+  Usage GetUsage(BufferCategory category) const;
+  Usage GetTotalUsage() const;
+
+  // Forgets the peaks, e.g. between two phases of a benchmark.
+  void ResetPeaks();
+
+  void PrintReport(std::ostream &out) const;
+
+  static BufferCategory CategoryForUsage(wgpu::BufferUsage usage);
+
+  const wgpu::Device &GetDevice() const { return device_; }
+
+private:
+  friend class TrackedBuffer;
+  void Release(BufferCategory category, uint64_t size);
+
+  wgpu::Device device_;
+
+  // Buffers may be created and released from different threads.
+  mutable std::mutex mutex_;
+  std::array<Usage, size_t(BufferCategory::Count)> categories_;
+  Usage total_;
+};
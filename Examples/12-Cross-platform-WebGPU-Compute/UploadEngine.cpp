@@ -0,0 +1,395 @@
+#include "UploadEngine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "DeviceHelpers.h"
+
+// Copies one buffer into another in chunks, on the worker threads and the
+// calling thread together. One copy at a time.
+class UploadEngine::CopyPool {
+public:
+  explicit CopyPool(uint32_t threads) {
+    for (uint32_t i = 0; i < threads; ++i) {
+      workers_.emplace_back(&CopyPool::WorkerLoop, this);
+    }
+  }
+
+  ~CopyPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void Copy(char *destination, const char *source, uint64_t size,
+            uint64_t chunkSize) {
+    {
+      // A worker woken late for the previous copy may still be looking at
+      // it; let it leave before the fields change.
+      std::unique_lock<std::mutex> lock(mutex_);
+      idle_.wait(lock, [this] { return active_ == 0; });
+      destination_ = destination;
+      source_ = source;
+      size_ = size;
+      chunkSize_ = chunkSize;
+      chunks_ = (size + chunkSize - 1) / chunkSize;
+      nextChunk_.store(0, std::memory_order_relaxed);
+      ++generation_;
+    }
+    wake_.notify_all();
+    CopyChunks();
+
+    // Every chunk has been claimed; wait for the workers still copying one.
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return active_ == 0; });
+  }
+
+private:
+  void CopyChunks() {
+    while (true) {
+      const uint64_t chunk =
+          nextChunk_.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= chunks_) {
+        return;
+      }
+      const uint64_t offset = chunk * chunkSize_;
+      std::memcpy(destination_ + offset, source_ + offset,
+                  std::min(chunkSize_, size_ - offset));
+    }
+  }
+
+  void WorkerLoop() {
+    uint64_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock,
+                   [&] { return stopping_ || generation_ != seen; });
+        if (stopping_) {
+          return;
+        }
+        seen = generation_;
+        ++active_;
+      }
+      CopyChunks();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_;
+      }
+      idle_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  bool stopping_ = false;
+  uint64_t generation_ = 0;
+  uint32_t active_ = 0;
+
+  // The current copy; only written while no worker is active.
+  char *destination_ = nullptr;
+  const char *source_ = nullptr;
+  uint64_t size_ = 0;
+  uint64_t chunkSize_ = 0;
+  uint64_t chunks_ = 0;
+  std::atomic<uint64_t> nextChunk_{0};
+};
+
+struct UploadEngine::Slot {
+  TrackedBuffer buffer;
+  // Null while the slot is submitted and waiting to be re-mapped.
+  char *mapped = nullptr;
+  uint64_t used = 0;
+  bool mapFailed = false;
+};
+
+const char *UploadStrategyName(UploadStrategy strategy) {
+  switch (strategy) {
+  case UploadStrategy::WriteBuffer:
+    return "WriteBuffer";
+  case UploadStrategy::MappedAtCreation:
+    return "MappedAtCreation";
+  case UploadStrategy::StagingRing:
+    return "StagingRing";
+  default:
+    return "?";
+  }
+}
+
+UploadEngine::UploadEngine(wgpu::Instance instance, wgpu::Device device,
+                           TrackedAllocator &allocator)
+    : UploadEngine(std::move(instance), std::move(device), allocator,
+                   Options{}) {}
+
+UploadEngine::UploadEngine(wgpu::Instance instance, wgpu::Device device,
+                           TrackedAllocator &allocator, Options options)
+    : instance_(std::move(instance)), device_(std::move(device)),
+      allocator_(allocator), options_(options),
+      copyPool_(std::make_unique<CopyPool>(options.copyThreads)) {
+  if (options_.ringSlots == 0 || options_.ringSlotSize % 4 != 0 ||
+      options_.copyChunkSize == 0) {
+    throw std::invalid_argument("UploadEngine: bad options");
+  }
+
+  // Slots start out mapped. Their addresses are handed to MapAsync, so the
+  // vector is never resized after this.
+  slots_.resize(options_.ringSlots);
+  for (Slot &slot : slots_) {
+    wgpu::BufferDescriptor slotDesc{
+        .usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc,
+        .size = options_.ringSlotSize,
+        .mappedAtCreation = true,
+    };
+    slot.buffer = allocator_.CreateBuffer(slotDesc, BufferCategory::Upload);
+    slot.mapped = static_cast<char *>(slot.buffer.Get().GetMappedRange());
+  }
+
+  if (options_.calibrate) {
+    Calibrate();
+  } else {
+    calibration_ = {{0, UploadStrategy::WriteBuffer},
+                    {options_.ringSlotSize, UploadStrategy::MappedAtCreation}};
+  }
+}
+
+UploadEngine::~UploadEngine() {
+  Flush();
+  // Let outstanding re-maps finish before their slots go away.
+  for (Slot &slot : slots_) {
+    while (slot.mapped == nullptr && !slot.mapFailed) {
+      instance_.ProcessEvents();
+    }
+  }
+}
+
+void UploadEngine::Calibrate() {
+  calibration_.clear();
+  for (uint64_t size : {uint64_t(4) << 10, uint64_t(64) << 10,
+                        uint64_t(1) << 20, uint64_t(16) << 20}) {
+    UploadStrategy best = UploadStrategy::WriteBuffer;
+    double bestBandwidth = 0.0;
+    for (UploadStrategy strategy :
+         {UploadStrategy::WriteBuffer, UploadStrategy::MappedAtCreation,
+          UploadStrategy::StagingRing}) {
+      // Once to warm up, then keep the better of two runs.
+      MeasureBandwidth(strategy, size);
+      const double bandwidth = std::max(MeasureBandwidth(strategy, size),
+                                        MeasureBandwidth(strategy, size));
+      if (bandwidth > bestBandwidth) {
+        bestBandwidth = bandwidth;
+        best = strategy;
+      }
+    }
+    calibration_.emplace_back(size, best);
+  }
+  stats_ = {};
+}
+
+UploadStrategy UploadEngine::Choose(uint64_t size) const {
+  // The entry for the largest calibrated size at or below `size`, or the
+  // smallest one.
+  UploadStrategy strategy = calibration_.front().second;
+  for (const auto &[calibratedSize, best] : calibration_) {
+    if (calibratedSize > size) {
+      break;
+    }
+    strategy = best;
+  }
+  return strategy;
+}
+
+double UploadEngine::MeasureBandwidth(UploadStrategy strategy, uint64_t size) {
+  // Repeat to move about 16 MiB, capped at 64 transfers.
+  const uint64_t repetitions =
+      std::clamp<uint64_t>((uint64_t(16) << 20) / size, 1, 64);
+  std::vector<char> data(size, 1);
+  wgpu::BufferDescriptor targetDesc{
+      .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst,
+      .size = size,
+  };
+  TrackedBuffer target = allocator_.CreateBuffer(targetDesc);
+  Finish();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < repetitions; ++i) {
+    Write(target.Get(), 0, data.data(), size, strategy);
+  }
+  Finish();
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return double(size) * repetitions / seconds;
+}
+
+TrackedBuffer UploadEngine::CreateBufferWithData(wgpu::BufferUsage usage,
+                                                 const void *data,
+                                                 uint64_t size) {
+  const UploadStrategy strategy = Choose(size);
+  if (strategy == UploadStrategy::MappedAtCreation) {
+    if (size % 4 != 0) {
+      throw std::invalid_argument("UploadEngine: size must be a multiple of 4");
+    }
+    wgpu::BufferDescriptor descriptor{
+        .usage = usage,
+        .size = size,
+        .mappedAtCreation = true,
+    };
+    TrackedBuffer buffer = allocator_.CreateBuffer(descriptor);
+    Copy(buffer.Get().GetMappedRange(), data, size);
+    buffer.Get().Unmap();
+    ++stats_.transfers[size_t(strategy)];
+    stats_.bytes[size_t(strategy)] += size;
+    return buffer;
+  }
+
+  wgpu::BufferDescriptor descriptor{
+      .usage = usage | wgpu::BufferUsage::CopyDst,
+      .size = size,
+  };
+  TrackedBuffer buffer = allocator_.CreateBuffer(descriptor);
+  Write(buffer.Get(), 0, data, size, strategy);
+  return buffer;
+}
+
+void UploadEngine::Write(const wgpu::Buffer &buffer, uint64_t offset,
+                         const void *data, uint64_t size) {
+  Write(buffer, offset, data, size, Choose(size));
+}
+
+void UploadEngine::Write(const wgpu::Buffer &buffer, uint64_t offset,
+                         const void *data, uint64_t size,
+                         UploadStrategy strategy) {
+  if (size % 4 != 0 || offset % 4 != 0) {
+    throw std::invalid_argument(
+        "UploadEngine: size and offset must be multiples of 4");
+  }
+  ++stats_.transfers[size_t(strategy)];
+  stats_.bytes[size_t(strategy)] += size;
+
+  switch (strategy) {
+  case UploadStrategy::WriteBuffer:
+    // Keep the queue order: pending ring copies go first.
+    Flush();
+    device_.GetQueue().WriteBuffer(buffer, offset, data, size);
+    return;
+
+  case UploadStrategy::MappedAtCreation: {
+    Flush();
+    wgpu::BufferDescriptor stagingDesc{
+        .usage = wgpu::BufferUsage::CopySrc,
+        .size = size,
+        .mappedAtCreation = true,
+    };
+    // Released right away; Dawn keeps it alive until the copy is done.
+    TrackedBuffer staging =
+        allocator_.CreateBuffer(stagingDesc, BufferCategory::Upload);
+    Copy(staging.Get().GetMappedRange(), data, size);
+    staging.Get().Unmap();
+    wgpu::CommandEncoder commandEncoder = device_.CreateCommandEncoder();
+    commandEncoder.CopyBufferToBuffer(staging.Get(), 0, buffer, offset, size);
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device_.GetQueue().Submit(1, &commands);
+    return;
+  }
+
+  case UploadStrategy::StagingRing: {
+    const char *source = static_cast<const char *>(data);
+    while (size > 0) {
+      Slot &slot = AcquireSlot();
+      const uint64_t count = std::min(size, options_.ringSlotSize - slot.used);
+      Copy(slot.mapped + slot.used, source, count);
+      if (!ringEncoder_) {
+        ringEncoder_ = device_.CreateCommandEncoder();
+      }
+      ringEncoder_.CopyBufferToBuffer(slot.buffer.Get(), slot.used, buffer,
+                                      offset, count);
+      slot.used += count;
+      if (slot.used == options_.ringSlotSize) {
+        SubmitSlot();
+      }
+      source += count;
+      offset += count;
+      size -= count;
+    }
+    return;
+  }
+
+  default:
+    throw std::invalid_argument("UploadEngine: unknown strategy");
+  }
+}
+
+void UploadEngine::Flush() {
+  if (slots_[currentSlot_].used > 0) {
+    SubmitSlot();
+  }
+}
+
+void UploadEngine::Finish() {
+  Flush();
+  WaitForQueue(instance_, device_);
+}
+
+void UploadEngine::Copy(void *destination, const void *source,
+                        uint64_t size) {
+  if (size < options_.parallelCopyMin) {
+    std::memcpy(destination, source, size);
+    return;
+  }
+  copyPool_->Copy(static_cast<char *>(destination),
+                  static_cast<const char *>(source), size,
+                  options_.copyChunkSize);
+}
+
+UploadEngine::Slot &UploadEngine::AcquireSlot() {
+  Slot &slot = slots_[currentSlot_];
+  // All slots in flight: wait for the oldest one to come back.
+  while (slot.mapped == nullptr && !slot.mapFailed) {
+    instance_.ProcessEvents();
+  }
+  if (slot.mapFailed) {
+    throw std::runtime_error("UploadEngine: failed to map a staging buffer");
+  }
+  return slot;
+}
+
+void UploadEngine::SubmitSlot() {
+  Slot &slot = slots_[currentSlot_];
+  slot.buffer.Get().Unmap();
+  slot.mapped = nullptr;
+
+  wgpu::CommandBuffer commands = ringEncoder_.Finish();
+  ringEncoder_ = nullptr;
+  device_.GetQueue().Submit(1, &commands);
+
+  // Resolves once the GPU is done copying out of the slot.
+  slot.buffer.Get().MapAsync(wgpu::MapMode::Write, 0, options_.ringSlotSize,
+                             &UploadEngine::OnSlotMapped,
+                             reinterpret_cast<void *>(&slot));
+  currentSlot_ = (currentSlot_ + 1) % slots_.size();
+}
+
+void UploadEngine::OnSlotMapped(WGPUBufferMapAsyncStatus status,
+                                void *userdata) {
+  Slot &slot = *reinterpret_cast<Slot *>(userdata);
+  slot.used = 0;
+  if (status != WGPUBufferMapAsyncStatus_Success) {
+    slot.mapFailed = true;
+    return;
+  }
+  slot.mapped = static_cast<char *>(slot.buffer.Get().GetMappedRange());
+}
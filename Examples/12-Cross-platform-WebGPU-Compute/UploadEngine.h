@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "TrackedAllocator.h"
+
+// Host-to-device uploads with a per-transfer choice of mechanism:
+//
+//   WriteBuffer       Queue::WriteBuffer; Dawn stages the data itself.
+//   MappedAtCreation  a fresh mappedAtCreation buffer. New buffers are
+//                     filled directly; existing ones get a temporary buffer
+//                     plus a CopyBufferToBuffer.
+//   StagingRing       persistent MapWrite buffers. Writes are packed into the
+//                     current slot and copied out with CopyBufferToBuffer; a
+//                     full slot is submitted and re-mapped asynchronously.
+//
+// Which one is fastest depends on the backend and the size, so the engine
+// times all three at a few sizes when it is created and then picks, for
+// each transfer, the winner at the largest calibrated size at or below the
+// transfer's size.
+//
+// Copies into mapped memory are split into chunks and spread over a small
+// pool of worker threads. Everything else, including every Dawn call, stays
+// on the thread that uses the engine, which must be the device's only user.
+//
+// Sizes and offsets must be multiples of 4 bytes.
+
+enum class UploadStrategy { WriteBuffer, MappedAtCreation, StagingRing, Count };
+
+const char *UploadStrategyName(UploadStrategy strategy);
+
+class UploadEngine {
+public:
+  struct Options {
+    // The ring has `ringSlots` buffers of `ringSlotSize` bytes.
+    uint64_t ringSlotSize = 4 << 20;
+    uint32_t ringSlots = 4;
+    // Worker threads for copies into mapped memory, besides the calling
+    // thread. Copies smaller than `parallelCopyMin` stay on the caller.
+    uint32_t copyThreads = 3;
+    uint64_t copyChunkSize = 1 << 20;
+    uint64_t parallelCopyMin = 2 << 20;
+    // Without calibration, WriteBuffer is used below `ringSlotSize` and
+    // MappedAtCreation above.
+    bool calibrate = true;
+  };
+
+  struct Stats {
+    uint64_t transfers[size_t(UploadStrategy::Count)] = {};
+    uint64_t bytes[size_t(UploadStrategy::Count)] = {};
+  };
+
+  UploadEngine(wgpu::Instance instance, wgpu::Device device,
+               TrackedAllocator &allocator);
+  UploadEngine(wgpu::Instance instance, wgpu::Device device,
+               TrackedAllocator &allocator, Options options);
+  ~UploadEngine();
+
+  UploadEngine(const UploadEngine &) = delete;
+  UploadEngine &operator=(const UploadEngine &) = delete;
+
+  // A new buffer with `usage` holding `data`. CopyDst is added when the
+  // chosen strategy needs it.
+  TrackedBuffer CreateBufferWithData(wgpu::BufferUsage usage, const void *data,
+                                     uint64_t size);
+
+  // Writes `data` into `buffer` (which needs CopyDst) at `offset`. The write
+  // is ordered before any work submitted after the next Flush(); ring
+  // writes may be held back until then.
+  void Write(const wgpu::Buffer &buffer, uint64_t offset, const void *data,
+             uint64_t size);
+  void Write(const wgpu::Buffer &buffer, uint64_t offset, const void *data,
+             uint64_t size, UploadStrategy strategy);
+
+  // Submits pending ring copies. Call before submitting work that reads
+  // the uploaded data.
+  void Flush();
+  // Flush() and wait until the queue is idle.
+  void Finish();
+
+  UploadStrategy Choose(uint64_t size) const;
+  // Upload bandwidth in bytes/s of `strategy` for transfers of `size`,
+  // including the wait for the GPU to finish the copies.
+  double MeasureBandwidth(UploadStrategy strategy, uint64_t size);
+  // Calibrated (size, fastest strategy) pairs, ascending by size.
+  const std::vector<std::pair<uint64_t, UploadStrategy>> &
+  GetCalibration() const {
+    return calibration_;
+  }
+
+  Stats GetStats() const { return stats_; }
+
+private:
+  class CopyPool;
+  struct Slot;
+
+  void Calibrate();
+  void Copy(void *destination, const void *source, uint64_t size);
+  Slot &AcquireSlot();
+  void SubmitSlot();
+  static void OnSlotMapped(WGPUBufferMapAsyncStatus status, void *userdata);
+
+  wgpu::Instance instance_;
+  wgpu::Device device_;
+  TrackedAllocator &allocator_;
+  Options options_;
+
+  std::unique_ptr<CopyPool> copyPool_;
+  std::vector<Slot> slots_;
+  size_t currentSlot_ = 0;
+  // Copies out of the current slot, submitted with it.
+  wgpu::CommandEncoder ringEncoder_;
+
+  std::vector<std::pair<uint64_t, UploadStrategy>> calibration_;
+  Stats stats_;
+};
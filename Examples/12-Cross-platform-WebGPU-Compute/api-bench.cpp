@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "DeviceHelpers.h"
+
+// Fixed per-call host costs of the API calls matmult.cpp makes, alone and in
+// the combinations it uses them in. Works on any adapter, including Dawn's
+// Null backend (no GPU work at all, so pure host overhead) and SwiftShader
+// (--cpu; CMakeLists.txt builds Dawn with it), so it can run on GPU-less CI
+// machines.
+//
+// The harness is a small stand-in for Google Benchmark, which this tree does
+// not depend on, with the same model: each benchmark is a loop over
+// a State, run with a growing iteration count until it takes at least
+// --min-time seconds, and reported as time per iteration.
+//
+// Usage: api-bench [--backend null|vulkan|metal|d3d12|d3d11|opengl|opengles]
+//                  [--cpu] [--filter SUBSTRING] [--min-time SECONDS] [--csv]
+
+namespace {
+
+wgpu::Instance instance;
+wgpu::Adapter adapter;
+wgpu::Device device;
+
+// The matmult.cpp kernel's bindings, with a trivial body.
+const char shaderCode[] = R"(
+    @group(0) @binding(0) var<storage, read> firstMatrix : array<f32>;
+    @group(0) @binding(1) var<storage, read> secondMatrix : array<f32>;
+    @group(0) @binding(2) var<storage, read_write> resultMatrix : array<f32>;
+
+    @compute @workgroup_size(8, 8)
+    fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
+        if (global_id.x == 0u && global_id.y == 0u) {
+            resultMatrix[0] = firstMatrix[0] * secondMatrix[0];
+        }
+    }
+)";
+
+// The same kernel with all three operands in one buffer, bound with dynamic
+// offsets. A buffer may not be read-only and writable storage in the same
+// dispatch, so every binding is read_write.
+const char arenaShaderCode[] = R"(
+    @group(0) @binding(0) var<storage, read_write> firstMatrix : array<f32>;
+    @group(0) @binding(1) var<storage, read_write> secondMatrix : array<f32>;
+    @group(0) @binding(2) var<storage, read_write> resultMatrix : array<f32>;
+
+    @compute @workgroup_size(8, 8)
+    fn main(@builtin(global_invocation_id) global_id : vec3<u32>) {
+        if (global_id.x == 0u && global_id.y == 0u) {
+            resultMatrix[0] = firstMatrix[0] * secondMatrix[0];
+        }
+    }
+)";
+
+constexpr uint64_t kBufferSize = 4096;
+
+class State {
+public:
+  explicit State(uint64_t iterations) : remaining_(iterations) {}
+
+  bool KeepRunning() {
+    if (remaining_ == 0) {
+      if (running_) {
+        PauseTiming();
+      }
+      return false;
+    }
+    if (!started_) {
+      started_ = true;
+      ResumeTiming();
+    }
+    --remaining_;
+    return true;
+  }
+
+  // Excludes setup inside the loop from the measurement.
+  void PauseTiming() {
+    elapsed_ += std::chrono::steady_clock::now() - start_;
+    running_ = false;
+  }
+  void ResumeTiming() {
+    start_ = std::chrono::steady_clock::now();
+    running_ = true;
+  }
+
+  double Seconds() const {
+    return std::chrono::duration<double>(elapsed_).count();
+  }
+
+private:
+  uint64_t remaining_;
+  bool started_ = false;
+  bool running_ = false;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::steady_clock::duration elapsed_{};
+};
+
+struct Benchmark {
+  const char *name;
+  void (*run)(State &state);
+};
+
+void MapAndWait(const wgpu::Buffer &buffer, wgpu::MapMode mode) {
+  bool done = false;
+  buffer.MapAsync(
+      mode, 0, kBufferSize,
+      [](WGPUBufferMapAsyncStatus status, void *userdata) {
+        if (status != WGPUBufferMapAsyncStatus_Success) {
+          std::cout << "Failed to map buffer" << std::endl;
+          exit(1);
+        }
+        *reinterpret_cast<bool *>(userdata) = true;
+      },
+      reinterpret_cast<void *>(&done));
+  while (!done) {
+    instance.ProcessEvents();
+  }
+}
+
+wgpu::Buffer CreateBuffer(wgpu::BufferUsage usage) {
+  wgpu::BufferDescriptor descriptor{.usage = usage, .size = kBufferSize};
+  return device.CreateBuffer(&descriptor);
+}
+
+wgpu::BindGroup CreateBindGroup(const wgpu::ComputePipeline &pipeline,
+                                const wgpu::Buffer (&buffers)[3]) {
+  const wgpu::BindGroupEntry entries[3] = {
+      BindingEntry(0, {.buffer = buffers[0]}),
+      BindingEntry(1, {.buffer = buffers[1]}),
+      BindingEntry(2, {.buffer = buffers[2]})};
+  return MakeBindGroup(device, pipeline, entries, 3);
+}
+
+// --- Single calls ---
+
+void BM_CreateBuffer(State &state) {
+  while (state.KeepRunning()) {
+    wgpu::Buffer buffer = CreateBuffer(wgpu::BufferUsage::Storage);
+  }
+}
+
+void BM_CreateBufferMappedAtCreation(State &state) {
+  const std::vector<float> data(kBufferSize / sizeof(float), 1.0f);
+  while (state.KeepRunning()) {
+    wgpu::BufferDescriptor descriptor{
+        .usage = wgpu::BufferUsage::Storage,
+        .size = kBufferSize,
+        .mappedAtCreation = true,
+    };
+    wgpu::Buffer buffer = device.CreateBuffer(&descriptor);
+    std::memcpy(buffer.GetMappedRange(), data.data(), kBufferSize);
+    buffer.Unmap();
+  }
+}
+
+void BM_CreateBindGroup(State &state) {
+  const wgpu::ComputePipeline pipeline = CreatePipeline(device, shaderCode);
+  const wgpu::Buffer buffers[3] = {
+      CreateBuffer(wgpu::BufferUsage::Storage),
+      CreateBuffer(wgpu::BufferUsage::Storage),
+      CreateBuffer(wgpu::BufferUsage::Storage)};
+  while (state.KeepRunning()) {
+    wgpu::BindGroup bindGroup = CreateBindGroup(pipeline, buffers);
+  }
+}
+
+void BM_CreateComputePipeline(State &state) {
+  while (state.KeepRunning()) {
+    wgpu::ComputePipeline pipeline = CreatePipeline(device, shaderCode);
+  }
+}
+
+void BM_CommandEncoderFinish(State &state) {
+  while (state.KeepRunning()) {
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+  }
+}
+
+void BM_SubmitEmpty(State &state) {
+  uint64_t submitted = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    wgpu::CommandBuffer commands = device.CreateCommandEncoder().Finish();
+    state.ResumeTiming();
+    device.GetQueue().Submit(1, &commands);
+    if (++submitted % 1024 == 0) {
+      state.PauseTiming();
+      WaitForQueue(instance, device);
+      state.ResumeTiming();
+    }
+  }
+  WaitForQueue(instance, device);
+}
+
+void BM_MapAsyncRoundTrip(State &state) {
+  const wgpu::Buffer buffer =
+      CreateBuffer(wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+  while (state.KeepRunning()) {
+    MapAndWait(buffer, wgpu::MapMode::Read);
+    buffer.GetConstMappedRange(0, kBufferSize);
+    buffer.Unmap();
+  }
+}
+
+// --- Combinations ---
+
+// Everything a dispatch costs on the host once the pipeline and bind group
+// exist, waiting for the queue every 64 submits.
+void BM_EncodeDispatchSubmit(State &state) {
+  const wgpu::ComputePipeline pipeline = CreatePipeline(device, shaderCode);
+  const wgpu::Buffer buffers[3] = {
+      CreateBuffer(wgpu::BufferUsage::Storage),
+      CreateBuffer(wgpu::BufferUsage::Storage),
+      CreateBuffer(wgpu::BufferUsage::Storage)};
+  const wgpu::BindGroup bindGroup = CreateBindGroup(pipeline, buffers);
+  uint64_t submitted = 0;
+  while (state.KeepRunning()) {
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    wgpu::ComputePassEncoder passEncoder = commandEncoder.BeginComputePass();
+    passEncoder.SetPipeline(pipeline);
+    passEncoder.SetBindGroup(0, bindGroup);
+    passEncoder.DispatchWorkgroups(1, 1);
+    passEncoder.End();
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+    if (++submitted % 64 == 0) {
+      WaitForQueue(instance, device);
+    }
+  }
+  WaitForQueue(instance, device);
+}
+
+// Same, plus a bind group per dispatch, as RunMatMult() does.
+void BM_BindGroupDispatchSubmit(State &state) {
+  const wgpu::ComputePipeline pipeline = CreatePipeline(device, shaderCode);
+  const wgpu::Buffer buffers[3] = {
+      CreateBuffer(wgpu::BufferUsage::Storage),
+      CreateBuffer(wgpu::BufferUsage::Storage),
+      CreateBuffer(wgpu::BufferUsage::Storage)};
+  uint64_t submitted = 0;
+  while (state.KeepRunning()) {
+    wgpu::BindGroup bindGroup = CreateBindGroup(pipeline, buffers);
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    wgpu::ComputePassEncoder passEncoder = commandEncoder.BeginComputePass();
+    passEncoder.SetPipeline(pipeline);
+    passEncoder.SetBindGroup(0, bindGroup);
+    passEncoder.DispatchWorkgroups(1, 1);
+    passEncoder.End();
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+    if (++submitted % 64 == 0) {
+      WaitForQueue(instance, device);
+    }
+  }
+  WaitForQueue(instance, device);
+}
+
+// Same, with the operands at new offsets of one buffer for every dispatch and
+// a single bind group whose dynamic offsets move to them.
+void BM_DynamicOffsetDispatchSubmit(State &state) {
+  constexpr uint32_t kSlots = 6;
+  wgpu::BufferDescriptor arenaDesc{
+      .usage = wgpu::BufferUsage::Storage,
+      .size = kBufferSize * kSlots,
+  };
+  const wgpu::Buffer arena = device.CreateBuffer(&arenaDesc);
+
+  wgpu::BindGroupLayoutEntry layoutEntries[3] = {};
+  wgpu::BindGroupEntry entries[3] = {};
+  for (uint32_t i = 0; i < 3; ++i) {
+    layoutEntries[i].binding = i;
+    layoutEntries[i].visibility = wgpu::ShaderStage::Compute;
+    layoutEntries[i].buffer.type = wgpu::BufferBindingType::Storage;
+    layoutEntries[i].buffer.hasDynamicOffset = true;
+    entries[i].binding = i;
+    entries[i].buffer = arena;
+    entries[i].size = kBufferSize;
+  }
+  wgpu::BindGroupLayoutDescriptor layoutDesc = {};
+  layoutDesc.entryCount = 3;
+  layoutDesc.entries = layoutEntries;
+  const wgpu::BindGroupLayout layout = device.CreateBindGroupLayout(&layoutDesc);
+  wgpu::PipelineLayoutDescriptor pipelineLayoutDesc = {};
+  pipelineLayoutDesc.bindGroupLayoutCount = 1;
+  pipelineLayoutDesc.bindGroupLayouts = &layout;
+
+  wgpu::ComputePipelineDescriptor pipelineDesc = {};
+  pipelineDesc.layout = device.CreatePipelineLayout(&pipelineLayoutDesc);
+  pipelineDesc.compute.module = CreateShaderModule(device, arenaShaderCode);
+  pipelineDesc.compute.entryPoint = "main";
+  const wgpu::ComputePipeline pipeline =
+      device.CreateComputePipeline(&pipelineDesc);
+
+  wgpu::BindGroupDescriptor bindGroupDesc = {};
+  bindGroupDesc.layout = layout;
+  bindGroupDesc.entryCount = 3;
+  bindGroupDesc.entries = entries;
+  const wgpu::BindGroup bindGroup = device.CreateBindGroup(&bindGroupDesc);
+
+  uint64_t submitted = 0;
+  while (state.KeepRunning()) {
+    // Alternate between the two halves of the buffer.
+    const uint32_t base = uint32_t(submitted % 2) * 3 * kBufferSize;
+    const uint32_t offsets[3] = {base, base + uint32_t(kBufferSize),
+                                 base + 2 * uint32_t(kBufferSize)};
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    wgpu::ComputePassEncoder passEncoder = commandEncoder.BeginComputePass();
+    passEncoder.SetPipeline(pipeline);
+    passEncoder.SetBindGroup(0, bindGroup, 3, offsets);
+    passEncoder.DispatchWorkgroups(1, 1);
+    passEncoder.End();
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+    if (++submitted % 64 == 0) {
+      WaitForQueue(instance, device);
+    }
+  }
+  WaitForQueue(instance, device);
+}
+
+// The whole of RunMatMult(): upload two matrices, create the result and read
+// buffers, the pipeline and the bind group, dispatch, copy and map the
+// result back.
+void BM_MatMultRoundTrip(State &state) {
+  const std::vector<float> matrix(kBufferSize / sizeof(float), 1.0f);
+  while (state.KeepRunning()) {
+    wgpu::Buffer buffers[3];
+    for (int i = 0; i < 2; ++i) {
+      wgpu::BufferDescriptor descriptor{
+          .usage = wgpu::BufferUsage::Storage,
+          .size = kBufferSize,
+          .mappedAtCreation = true,
+      };
+      buffers[i] = device.CreateBuffer(&descriptor);
+      std::memcpy(buffers[i].GetMappedRange(), matrix.data(), kBufferSize);
+      buffers[i].Unmap();
+    }
+    buffers[2] =
+        CreateBuffer(wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    const wgpu::ComputePipeline pipeline = CreatePipeline(device, shaderCode);
+    const wgpu::BindGroup bindGroup = CreateBindGroup(pipeline, buffers);
+
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    wgpu::ComputePassEncoder passEncoder = commandEncoder.BeginComputePass();
+    passEncoder.SetPipeline(pipeline);
+    passEncoder.SetBindGroup(0, bindGroup);
+    passEncoder.DispatchWorkgroups(1, 1);
+    passEncoder.End();
+    const wgpu::Buffer readBuffer =
+        CreateBuffer(wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead);
+    commandEncoder.CopyBufferToBuffer(buffers[2], 0, readBuffer, 0,
+                                      kBufferSize);
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+
+    MapAndWait(readBuffer, wgpu::MapMode::Read);
+    readBuffer.GetConstMappedRange(0, kBufferSize);
+    readBuffer.Unmap();
+  }
+}
+
+const Benchmark benchmarks[] = {
+    {"CreateBuffer", BM_CreateBuffer},
+    {"CreateBufferMappedAtCreation", BM_CreateBufferMappedAtCreation},
+    {"CreateBindGroup", BM_CreateBindGroup},
+    {"CreateComputePipeline", BM_CreateComputePipeline},
+    {"CommandEncoderFinish", BM_CommandEncoderFinish},
+    {"SubmitEmpty", BM_SubmitEmpty},
+    {"MapAsyncRoundTrip", BM_MapAsyncRoundTrip},
+    {"EncodeDispatchSubmit", BM_EncodeDispatchSubmit},
+    {"BindGroupDispatchSubmit", BM_BindGroupDispatchSubmit},
+    {"DynamicOffsetDispatchSubmit", BM_DynamicOffsetDispatchSubmit},
+    {"MatMultRoundTrip", BM_MatMultRoundTrip},
+};
+
+// Like Google Benchmark: start with one iteration and grow the count until
+// a run takes at least `minTime`.
+void RunBenchmark(const Benchmark &benchmark, double minTime, bool csv) {
+  uint64_t iterations = 1;
+  double seconds = 0.0;
+  while (true) {
+    State state(iterations);
+    benchmark.run(state);
+    seconds = state.Seconds();
+    if (seconds >= minTime || iterations >= 1'000'000'000) {
+      break;
+    }
+    const double scale =
+        seconds > 0.0 ? std::clamp(1.4 * minTime / seconds, 2.0, 10.0) : 10.0;
+    iterations = uint64_t(double(iterations) * scale);
+  }
+
+  const double nanoseconds = seconds * 1e9 / double(iterations);
+  if (csv) {
+    std::cout << benchmark.name << "," << nanoseconds << "," << iterations
+              << std::endl;
+  } else {
+    std::cout << std::left << std::setw(32) << benchmark.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0)
+              << nanoseconds << " ns" << std::setw(14) << iterations
+              << std::endl;
+  }
+}
+
+wgpu::BackendType ParseBackend(const char *name) {
+  const std::pair<const char *, wgpu::BackendType> backends[] = {
+      {"null", wgpu::BackendType::Null},
+      {"vulkan", wgpu::BackendType::Vulkan},
+      {"metal", wgpu::BackendType::Metal},
+      {"d3d12", wgpu::BackendType::D3D12},
+      {"d3d11", wgpu::BackendType::D3D11},
+      {"opengl", wgpu::BackendType::OpenGL},
+      {"opengles", wgpu::BackendType::OpenGLES},
+  };
+  for (const auto &[backendName, type] : backends) {
+    if (std::strcmp(name, backendName) == 0) {
+      return type;
+    }
+  }
+  std::cout << "Unknown backend: " << name << std::endl;
+  exit(1);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  DeviceOptions deviceOptions;
+  std::string filter;
+  double minTime = 0.5;
+  bool csv = false;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--cpu") == 0) {
+      deviceOptions.forceFallbackAdapter = true;
+    } else if (std::strcmp(argv[i], "--csv") == 0) {
+      csv = true;
+    } else if (hasValue && std::strcmp(argv[i], "--backend") == 0) {
+      deviceOptions.backendType = ParseBackend(argv[++i]);
+    } else if (hasValue && std::strcmp(argv[i], "--filter") == 0) {
+      filter = argv[++i];
+    } else if (hasValue && std::strcmp(argv[i], "--min-time") == 0) {
+      minTime = std::atof(argv[++i]);
+    } else {
+      std::cout << "Unknown argument: " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  instance = wgpu::CreateInstance();
+  adapter = RequestAdapterSync(instance, deviceOptions);
+  device = RequestDeviceSync(instance, adapter);
+
+  wgpu::AdapterProperties properties{};
+  adapter.GetProperties(&properties);
+  if (csv) {
+    std::cout << "benchmark,ns_per_iteration,iterations" << std::endl;
+  } else {
+    std::cout << "Adapter: " << properties.name << " ("
+              << properties.driverDescription << ")" << std::endl;
+    std::cout << std::left << std::setw(32) << "Benchmark" << std::right
+              << std::setw(17) << "Time" << std::setw(14) << "Iterations"
+              << std::endl;
+  }
+
+  for (const Benchmark &benchmark : benchmarks) {
+    if (std::strstr(benchmark.name, filter.c_str()) != nullptr) {
+      RunBenchmark(benchmark, minTime, csv);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "Conv2d.h"
+#include "DeviceHelpers.h"
+#include "TrackedAllocator.h"
+
+// Checks the implicit-GEMM and im2col + GEMM convolutions against a CPU
+// reference for both layouts, then compares their throughput and peak device
+// memory on a few typical layers.
+//
+// Usage: conv-bench [--iterations I]
+
+namespace {
+
+wgpu::Instance instance;
+wgpu::Device device;
+
+const char *LayoutName(TensorLayout layout) {
+  return layout == TensorLayout::NCHW ? "NCHW" : "NHWC";
+}
+
+const char *AlgorithmName(ConvAlgorithm algorithm) {
+  return algorithm == ConvAlgorithm::ImplicitGemm ? "implicit" : "im2col";
+}
+
+std::vector<float> RandomTensor(size_t count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> tensor(count);
+  for (float &value : tensor) {
+    value = dist(rng);
+  }
+  return tensor;
+}
+
+// Reference in NCHW / OIHW.
+std::vector<float> CpuConv(const Conv2dShape &shape,
+                           const std::vector<float> &input,
+                           const std::vector<float> &weights) {
+  const uint32_t outH = shape.OutHeight();
+  const uint32_t outW = shape.OutWidth();
+  std::vector<float> output(shape.OutputSize(), 0.0f);
+  for (uint32_t n = 0; n < shape.batch; ++n)
+    for (uint32_t k = 0; k < shape.outChannels; ++k)
+      for (uint32_t oh = 0; oh < outH; ++oh)
+        for (uint32_t ow = 0; ow < outW; ++ow) {
+          float sum = 0.0f;
+          for (uint32_t c = 0; c < shape.inChannels; ++c)
+            for (uint32_t r = 0; r < shape.kernelHeight; ++r)
+              for (uint32_t s = 0; s < shape.kernelWidth; ++s) {
+                const int ih = int(oh * shape.strideHeight +
+                                   r * shape.dilationHeight) -
+                               int(shape.padHeight);
+                const int iw = int(ow * shape.strideWidth +
+                                   s * shape.dilationWidth) -
+                               int(shape.padWidth);
+                if (ih < 0 || iw < 0 || ih >= int(shape.inHeight) ||
+                    iw >= int(shape.inWidth)) {
+                  continue;
+                }
+                sum += input[((size_t(n) * shape.inChannels + c) *
+                                  shape.inHeight +
+                              ih) *
+                                 shape.inWidth +
+                             iw] *
+                       weights[((size_t(k) * shape.inChannels + c) *
+                                    shape.kernelHeight +
+                                r) *
+                                   shape.kernelWidth +
+                               s];
+              }
+          output[((size_t(n) * shape.outChannels + k) * outH + oh) * outW +
+                 ow] = sum;
+        }
+  return output;
+}
+
+// NCHW -> NHWC for activations, OIHW -> HWIO for weights.
+std::vector<float> ToChannelsLast(const std::vector<float> &tensor,
+                                  uint32_t n, uint32_t c, uint32_t h,
+                                  uint32_t w) {
+  std::vector<float> result(tensor.size());
+  for (uint32_t in = 0; in < n; ++in)
+    for (uint32_t ic = 0; ic < c; ++ic)
+      for (uint32_t ih = 0; ih < h; ++ih)
+        for (uint32_t iw = 0; iw < w; ++iw)
+          result[((size_t(in) * h + ih) * w + iw) * c + ic] =
+              tensor[((size_t(in) * c + ic) * h + ih) * w + iw];
+  return result;
+}
+
+std::vector<float> WeightsToHWIO(const std::vector<float> &weights,
+                                 const Conv2dShape &shape) {
+  std::vector<float> result(weights.size());
+  for (uint32_t k = 0; k < shape.outChannels; ++k)
+    for (uint32_t c = 0; c < shape.inChannels; ++c)
+      for (uint32_t r = 0; r < shape.kernelHeight; ++r)
+        for (uint32_t s = 0; s < shape.kernelWidth; ++s)
+          result[((size_t(r) * shape.kernelWidth + s) * shape.inChannels +
+                  c) *
+                     shape.outChannels +
+                 k] = weights[((size_t(k) * shape.inChannels + c) *
+                                   shape.kernelHeight +
+                               r) *
+                                  shape.kernelWidth +
+                              s];
+  return result;
+}
+
+struct ConvRun {
+  double seconds = 0.0;
+  uint64_t peakBytes = 0;
+  std::vector<float> output; // in the run's layout
+};
+
+ConvRun RunConv(const Conv2dShape &shape, TensorLayout layout,
+                ConvAlgorithm algorithm, const std::vector<float> &input,
+                const std::vector<float> &weights, uint32_t iterations) {
+  TrackedAllocator allocator(device);
+  auto createBuffer = [&](uint64_t count) {
+    wgpu::BufferDescriptor descriptor{
+        .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc |
+                 wgpu::BufferUsage::CopyDst,
+        .size = count * sizeof(float),
+    };
+    return allocator.CreateBuffer(descriptor);
+  };
+  TrackedBuffer inputBuffer = createBuffer(shape.InputSize());
+  TrackedBuffer weightBuffer = createBuffer(shape.WeightSize());
+  TrackedBuffer outputBuffer = createBuffer(shape.OutputSize());
+  device.GetQueue().WriteBuffer(inputBuffer.Get(), 0, input.data(),
+                                input.size() * sizeof(float));
+  device.GetQueue().WriteBuffer(weightBuffer.Get(), 0, weights.data(),
+                                weights.size() * sizeof(float));
+
+  Conv2d conv(device, allocator, layout, shape, algorithm);
+  auto encode = [&](uint32_t count) {
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    for (uint32_t i = 0; i < count; ++i) {
+      conv.Encode(commandEncoder, {.buffer = inputBuffer.Get()},
+                  {.buffer = weightBuffer.Get()},
+                  {.buffer = outputBuffer.Get()});
+    }
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+  };
+
+  // Warm up (pipeline creation, first use of the buffers).
+  encode(1);
+  WaitForQueue(instance, device);
+
+  ConvRun run;
+  const auto start = std::chrono::steady_clock::now();
+  encode(iterations);
+  WaitForQueue(instance, device);
+  run.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                iterations;
+  run.peakBytes = allocator.GetTotalUsage().peakBytes;
+  run.output =
+      ReadBack<float>(instance, allocator, {.buffer = outputBuffer.Get()},
+                      shape.OutputSize() * sizeof(float));
+  return run;
+}
+
+bool Verify(const Conv2dShape &shape) {
+  const std::vector<float> input = RandomTensor(shape.InputSize(), 1);
+  const std::vector<float> weights = RandomTensor(shape.WeightSize(), 2);
+  const std::vector<float> expected = CpuConv(shape, input, weights);
+  const std::vector<float> expectedNHWC =
+      ToChannelsLast(expected, shape.batch, shape.outChannels,
+                     shape.OutHeight(), shape.OutWidth());
+
+  for (TensorLayout layout : {TensorLayout::NCHW, TensorLayout::NHWC}) {
+    const bool nchw = layout == TensorLayout::NCHW;
+    const std::vector<float> layoutInput =
+        nchw ? input
+             : ToChannelsLast(input, shape.batch, shape.inChannels,
+                              shape.inHeight, shape.inWidth);
+    const std::vector<float> layoutWeights =
+        nchw ? weights : WeightsToHWIO(weights, shape);
+    const std::vector<float> &reference = nchw ? expected : expectedNHWC;
+
+    for (ConvAlgorithm algorithm :
+         {ConvAlgorithm::ImplicitGemm, ConvAlgorithm::Im2colGemm}) {
+      const ConvRun run =
+          RunConv(shape, layout, algorithm, layoutInput, layoutWeights, 1);
+      for (size_t i = 0; i < reference.size(); ++i) {
+        if (std::fabs(run.output[i] - reference[i]) > 1e-3f) {
+          std::cout << LayoutName(layout) << " " << AlgorithmName(algorithm)
+                    << " mismatch at " << i << ": " << run.output[i]
+                    << " != " << reference[i] << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t iterations = 20;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--iterations") == 0) {
+      iterations = std::max(1, std::atoi(argv[i + 1]));
+    }
+  }
+
+  instance = wgpu::CreateInstance();
+  wgpu::Adapter adapter = RequestAdapterSync(instance);
+  std::cout << "GPU Adapter acquired." << std::endl;
+  device = RequestDeviceSync(instance, adapter);
+  std::cout << "GPU Device acquired." << std::endl;
+
+  // Odd sizes, stride, padding and dilation all at once.
+  const Conv2dShape verifyShape{.batch = 2,
+                                .inChannels = 5,
+                                .inHeight = 13,
+                                .inWidth = 11,
+                                .outChannels = 7,
+                                .kernelHeight = 3,
+                                .kernelWidth = 3,
+                                .strideHeight = 2,
+                                .strideWidth = 1,
+                                .padHeight = 1,
+                                .padWidth = 2,
+                                .dilationHeight = 1,
+                                .dilationWidth = 2};
+  if (!Verify(verifyShape)) {
+    return 1;
+  }
+  std::cout << "All layouts and algorithms verified against the CPU."
+            << std::endl;
+
+  const std::pair<const char *, Conv2dShape> layers[] = {
+      {"3x3 64->64 56x56",
+       {.batch = 8, .inChannels = 64, .inHeight = 56, .inWidth = 56,
+        .outChannels = 64, .kernelHeight = 3, .kernelWidth = 3,
+        .padHeight = 1, .padWidth = 1}},
+      {"3x3/2 128->256 28x28",
+       {.batch = 8, .inChannels = 128, .inHeight = 28, .inWidth = 28,
+        .outChannels = 256, .kernelHeight = 3, .kernelWidth = 3,
+        .strideHeight = 2, .strideWidth = 2, .padHeight = 1,
+        .padWidth = 1}},
+      {"3x3 d2 256->256 14x14",
+       {.batch = 8, .inChannels = 256, .inHeight = 14, .inWidth = 14,
+        .outChannels = 256, .kernelHeight = 3, .kernelWidth = 3,
+        .padHeight = 2, .padWidth = 2, .dilationHeight = 2,
+        .dilationWidth = 2}},
+      {"1x1 256->1024 14x14",
+       {.batch = 8, .inChannels = 256, .inHeight = 14, .inWidth = 14,
+        .outChannels = 1024}},
+  };
+
+  std::cout << "layer                   layout  algorithm  GFLOP/s   "
+               "peak MB"
+            << std::endl;
+  for (const auto &[name, shape] : layers) {
+    const std::vector<float> input = RandomTensor(shape.InputSize(), 3);
+    const std::vector<float> weights = RandomTensor(shape.WeightSize(), 4);
+    for (TensorLayout layout : {TensorLayout::NCHW, TensorLayout::NHWC}) {
+      for (ConvAlgorithm algorithm :
+           {ConvAlgorithm::ImplicitGemm, ConvAlgorithm::Im2colGemm}) {
+        const ConvRun run =
+            RunConv(shape, layout, algorithm, input, weights, iterations);
+        std::cout << name << "\t" << LayoutName(layout) << "\t"
+                  << AlgorithmName(algorithm) << "\t   "
+                  << shape.Flops() / run.seconds * 1e-9 << "\t"
+                  << run.peakBytes / (1024.0 * 1024.0) << std::endl;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "DeviceHelpers.h"
+#include "Fft.h"
+#include "TrackedAllocator.h"
+
+// Checks the batched Stockham FFT against a CPU FFT for 1D and 2D shapes on
+// both the workgroup-memory and the multi-pass paths, then compares GPU and
+// single-threaded CPU throughput across transform sizes.
+//
+// Usage: fft-bench [--iterations I] [--elements E]
+
+namespace {
+
+using Complex = std::complex<float>;
+
+wgpu::Instance instance;
+wgpu::Device device;
+
+std::vector<Complex> RandomSignal(size_t count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<Complex> signal(count);
+  for (Complex &value : signal) {
+    value = Complex(dist(rng), dist(rng));
+  }
+  return signal;
+}
+
+// Iterative radix-2 Cooley-Tukey on `count` transforms of length n, each
+// `stride` elements apart within a transform and `distance` apart from the
+// next one.
+template <typename T>
+void CpuFft(std::complex<T> *data, uint32_t n, uint32_t count,
+            uint32_t stride, uint32_t distance, bool inverse) {
+  const T sign = inverse ? T(1) : T(-1);
+  std::vector<std::complex<T>> twiddles(n / 2);
+  for (uint32_t k = 0; k < n / 2; ++k) {
+    twiddles[k] = std::polar(T(1), sign * T(2) * std::numbers::pi_v<T> *
+                                       T(k) / T(n));
+  }
+  std::vector<std::complex<T>> x(n);
+  for (uint32_t t = 0; t < count; ++t) {
+    std::complex<T> *transform = data + size_t(t) * distance;
+    for (uint32_t i = 0, j = 0; i < n; ++i) {
+      x[j] = transform[size_t(i) * stride];
+      // j = bit-reverse(i + 1)
+      uint32_t bit = n >> 1;
+      for (; j & bit; bit >>= 1) {
+        j ^= bit;
+      }
+      j |= bit;
+    }
+    for (uint32_t length = 2; length <= n; length <<= 1) {
+      const uint32_t step = n / length;
+      for (uint32_t start = 0; start < n; start += length) {
+        for (uint32_t k = 0; k < length / 2; ++k) {
+          const std::complex<T> a = x[start + k];
+          const std::complex<T> b = x[start + k + length / 2] * twiddles[k * step];
+          x[start + k] = a + b;
+          x[start + k + length / 2] = a - b;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      transform[size_t(i) * stride] = inverse ? x[i] / T(n) : x[i];
+    }
+  }
+}
+
+template <typename T>
+void CpuFft(std::vector<std::complex<T>> &data, const FftShape &shape,
+            bool inverse) {
+  for (uint32_t b = 0; b < shape.batch; ++b) {
+    std::complex<T> *image = data.data() + size_t(b) * shape.width * shape.height;
+    if (shape.width > 1) {
+      CpuFft(image, shape.width, shape.height, 1, shape.width, inverse);
+    }
+    if (shape.height > 1) {
+      CpuFft(image, shape.height, shape.width, shape.width, 1, inverse);
+    }
+  }
+}
+
+struct FftRun {
+  double seconds = 0.0;
+  std::vector<Complex> output;
+};
+
+// Runs `iterations` transforms in `direction` on `signal` and times them.
+FftRun RunFft(const FftShape &shape, const std::vector<Complex> &signal,
+              FftDirection direction, uint32_t iterations) {
+  TrackedAllocator allocator(device);
+  const uint64_t size = shape.Elements() * sizeof(Complex);
+  wgpu::BufferDescriptor dataDesc{
+      .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc |
+               wgpu::BufferUsage::CopyDst,
+      .size = size,
+  };
+  TrackedBuffer dataBuffer = allocator.CreateBuffer(dataDesc);
+  device.GetQueue().WriteBuffer(dataBuffer.Get(), 0, signal.data(), size);
+
+  Fft fft(device, allocator, shape);
+  auto encode = [&](uint32_t count) {
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    for (uint32_t i = 0; i < count; ++i) {
+      fft.Encode(commandEncoder, {.buffer = dataBuffer.Get()}, direction);
+    }
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+  };
+
+  FftRun run;
+  if (iterations > 1) {
+    // Warm up (pipeline creation), then restore the input.
+    encode(1);
+    WaitForQueue(instance, device);
+    const auto start = std::chrono::steady_clock::now();
+    encode(iterations);
+    WaitForQueue(instance, device);
+    run.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() /
+                  iterations;
+    device.GetQueue().WriteBuffer(dataBuffer.Get(), 0, signal.data(), size);
+  }
+  encode(1);
+  run.output = ReadBack<Complex>(instance, allocator,
+                                 {.buffer = dataBuffer.Get()}, size);
+  return run;
+}
+
+bool Verify(const FftShape &shape) {
+  const std::vector<Complex> signal = RandomSignal(shape.Elements(), 1);
+  std::vector<std::complex<double>> expected(signal.begin(), signal.end());
+  CpuFft(expected, shape, false);
+
+  const FftRun forward = RunFft(shape, signal, FftDirection::Forward, 1);
+  const FftRun inverse =
+      RunFft(shape, forward.output, FftDirection::Inverse, 1);
+
+  // FFT error grows with log(n) times the signal's rms; scale the tolerance
+  // by sqrt(n) to compare against the unnormalized forward output.
+  const double tolerance =
+      1e-5 * std::sqrt(double(shape.width) * shape.height) *
+      std::log2(2.0 * shape.width * shape.height);
+  for (size_t i = 0; i < signal.size(); ++i) {
+    const double forwardError =
+        std::abs(std::complex<double>(forward.output[i]) - expected[i]);
+    const double roundTripError = std::abs(inverse.output[i] - signal[i]);
+    if (forwardError > tolerance || roundTripError > 1e-4) {
+      std::cout << shape.width << "x" << shape.height << " x" << shape.batch
+                << " mismatch at " << i << ": " << forward.output[i]
+                << " != " << expected[i] << ", round trip "
+                << inverse.output[i] << " != " << signal[i] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t iterations = 20;
+  uint32_t elements = 1 << 22;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--iterations") == 0) {
+      iterations = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--elements") == 0) {
+      elements = std::max(1, std::atoi(argv[i + 1]));
+    }
+  }
+
+  instance = wgpu::CreateInstance();
+  wgpu::Adapter adapter = RequestAdapterSync(instance);
+  std::cout << "GPU Adapter acquired." << std::endl;
+  device = RequestDeviceSync(instance, adapter);
+  std::cout << "GPU Device acquired." << std::endl;
+
+  // Every radix mix, both paths (with the default 16 KiB of workgroup
+  // memory, lengths up to 2048 run in workgroup memory), 1D and 2D.
+  const FftShape verifyShapes[] = {
+      {.width = 2, .batch = 3},
+      {.width = 16, .batch = 5},
+      {.width = 128, .batch = 4},
+      {.width = 2048, .batch = 2},
+      {.width = 8192, .batch = 2},
+      {.width = 32, .height = 64, .batch = 2},
+      {.width = 4096, .height = 8},
+  };
+  for (const FftShape &shape : verifyShapes) {
+    if (!Verify(shape)) {
+      return 1;
+    }
+  }
+  std::cout << "Forward and inverse transforms verified against the CPU."
+            << std::endl;
+
+  std::vector<FftShape> shapes;
+  for (uint32_t n = 64; n <= (1u << 20) && n <= elements; n *= 4) {
+    shapes.push_back({.width = n, .batch = std::max(1u, elements / n)});
+  }
+  for (uint32_t n = 256; n * n <= elements; n *= 2) {
+    shapes.push_back(
+        {.width = n, .height = n, .batch = std::max(1u, elements / (n * n))});
+  }
+
+  std::cout << "shape                 batch   radices   GPU GFLOP/s   "
+               "CPU GFLOP/s"
+            << std::endl;
+  for (const FftShape &shape : shapes) {
+    const std::vector<Complex> signal = RandomSignal(shape.Elements(), 2);
+    const FftRun run =
+        RunFft(shape, signal, FftDirection::Forward, iterations);
+
+    std::vector<Complex> cpu = signal;
+    const auto start = std::chrono::steady_clock::now();
+    CpuFft(cpu, shape, false);
+    const double cpuSeconds = std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+
+    std::cout << shape.width << "x" << shape.height << "\t\t" << shape.batch
+              << "\t";
+    for (uint32_t radix : Fft::Radices(shape.width)) {
+      std::cout << radix;
+    }
+    std::cout << "\t  " << shape.Flops() / run.seconds * 1e-9 << "\t"
+              << shape.Flops() / cpuSeconds * 1e-9 << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "DeviceHelpers.h"
+#include "GemmRuntime.h"
+
+// Many host threads submit GEMM jobs to one GemmRuntime at the same time.
+// Reports jobs/s and GFLOP/s for an increasing number of submitting threads.
+//
+// Usage: matmult-runtime [--size N] [--jobs J] [--max-threads T]
+
+namespace {
+
+std::vector<float> RandomMatrix(size_t count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> matrix(count);
+  for (float &value : matrix) {
+    value = dist(rng);
+  }
+  return matrix;
+}
+
+std::vector<float> CpuMatMult(const std::vector<float> &a,
+                              const std::vector<float> &b, uint32_t m,
+                              uint32_t n, uint32_t k) {
+  std::vector<float> c(size_t(m) * n, 0.0f);
+  for (uint32_t row = 0; row < m; ++row) {
+    for (uint32_t i = 0; i < k; ++i) {
+      const float value = a[size_t(row) * k + i];
+      for (uint32_t col = 0; col < n; ++col) {
+        c[size_t(row) * n + col] += value * b[size_t(i) * n + col];
+      }
+    }
+  }
+  return c;
+}
+
+bool Verify(GemmRuntime &runtime, uint32_t size) {
+  const std::vector<float> a = RandomMatrix(size_t(size) * size, 1);
+  const std::vector<float> b = RandomMatrix(size_t(size) * size, 2);
+  const std::vector<float> expected = CpuMatMult(a, b, size, size, size);
+  const std::vector<float> result =
+      runtime.Submit(size, size, size, a, b).get();
+
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (std::fabs(result[i] - expected[i]) > 1e-3f * size) {
+      std::cout << "Mismatch at " << i << ": " << result[i]
+                << " != " << expected[i] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t size = 256;
+  uint32_t jobsPerThread = 64;
+  uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--size") == 0) {
+      size = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--jobs") == 0) {
+      jobsPerThread = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--max-threads") == 0) {
+      maxThreads = std::atoi(argv[i + 1]);
+    }
+  }
+
+  wgpu::Instance instance = wgpu::CreateInstance();
+  wgpu::Adapter adapter = RequestAdapterSync(instance);
+  std::cout << "GPU Adapter acquired." << std::endl;
+  wgpu::Device device = RequestDeviceSync(instance, adapter);
+  std::cout << "GPU Device acquired." << std::endl;
+
+  // A long-running benchmark, so the upload calibration pays off.
+  GemmRuntime runtime(instance, device,
+                      GemmRuntime::Options{.upload = {.calibrate = true}});
+
+  if (!Verify(runtime, 67)) {
+    return 1;
+  }
+  std::cout << "Result verified against the CPU." << std::endl;
+
+  const std::vector<float> a = RandomMatrix(size_t(size) * size, 3);
+  const std::vector<float> b = RandomMatrix(size_t(size) * size, 4);
+  const double flopsPerJob = 2.0 * size * size * size;
+
+  std::cout << "threads  jobs   jobs/s     GFLOP/s  avg batch" << std::endl;
+  for (uint32_t threads = 1; threads <= maxThreads; threads *= 2) {
+    const GemmRuntime::Stats before = runtime.GetStats();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&]() {
+        std::vector<std::future<std::vector<float>>> futures;
+        futures.reserve(jobsPerThread);
+        for (uint32_t j = 0; j < jobsPerThread; ++j) {
+          futures.push_back(runtime.Submit(size, size, size, a, b));
+        }
+        for (auto &future : futures) {
+          future.get();
+        }
+      });
+    }
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    const GemmRuntime::Stats after = runtime.GetStats();
+    const uint64_t jobs = after.jobs - before.jobs;
+    const uint64_t batches = after.batches - before.batches;
+
+    std::cout << threads << "\t " << jobs << "\t" << jobs / seconds << "\t"
+              << jobs * flopsPerJob / seconds * 1e-9 << "\t"
+              << double(jobs) / std::max<uint64_t>(batches, 1) << std::endl;
+  }
+
+  const GemmRuntime::Stats stats = runtime.GetStats();
+  std::cout << stats.arenaJobs << " of " << stats.jobs
+            << " jobs ran in the operand arena." << std::endl;
+
+  std::cout << "Device memory:" << std::endl;
+  runtime.PrintMemoryReport(std::cout);
+  return 0;
+}
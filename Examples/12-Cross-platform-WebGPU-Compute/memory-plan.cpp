@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "BufferPlanner.h"
+#include "DeviceHelpers.h"
+#include "GemmPipeline.h"
+#include "TrackedAllocator.h"
+
+// Runs a chain of GEMMs, X[i+1] = X[i] * W[i], entirely on the device, once
+// with one buffer per intermediate and once with intermediates aliased by
+// BufferPlanner. Prints the memory report of both runs and checks that they
+// produce the same output.
+//
+// Usage: memory-plan [--batch B] [--width N] [--layers L]
+
+namespace {
+
+wgpu::Instance instance;
+wgpu::Device device;
+
+struct Workload {
+  uint32_t batch = 4096;
+  uint32_t width = 1024;
+  uint32_t layers = 8;
+
+  std::vector<float> input;
+  std::vector<std::vector<float>> weights;
+};
+
+std::vector<float> RandomMatrix(size_t count, float scale, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-scale, scale);
+  std::vector<float> matrix(count);
+  for (float &value : matrix) {
+    value = dist(rng);
+  }
+  return matrix;
+}
+
+std::vector<float> Run(const Workload &workload, bool alias) {
+  TrackedAllocator allocator(device);
+
+  const uint64_t activationSize =
+      uint64_t(workload.batch) * workload.width * sizeof(float);
+  const uint64_t weightSize =
+      uint64_t(workload.width) * workload.width * sizeof(float);
+
+  // X[0] and X[layers] belong to the caller; X[1..layers-1] are
+  // intermediates that only live between the two GEMMs that touch them.
+  BufferPlanner planner;
+  std::vector<PlannedBufferId> activations;
+  std::vector<PlannedBufferId> weights;
+  for (uint32_t i = 0; i <= workload.layers; ++i) {
+    const bool intermediate = i != 0 && i != workload.layers;
+    activations.push_back(planner.AddBuffer(activationSize, intermediate));
+  }
+  for (uint32_t i = 0; i < workload.layers; ++i) {
+    weights.push_back(planner.AddBuffer(weightSize, false));
+  }
+  for (uint32_t i = 0; i < workload.layers; ++i) {
+    planner.AddOp({activations[i], weights[i], activations[i + 1]});
+  }
+
+  const BufferPlan plan = planner.Plan(alias);
+  PlannedBuffers buffers(allocator, plan,
+                         wgpu::BufferUsage::Storage |
+                             wgpu::BufferUsage::CopySrc |
+                             wgpu::BufferUsage::CopyDst);
+
+  wgpu::Queue queue = device.GetQueue();
+  const BufferBinding input = buffers.Binding(activations[0]);
+  queue.WriteBuffer(input.buffer, input.offset, workload.input.data(),
+                    activationSize);
+  for (uint32_t i = 0; i < workload.layers; ++i) {
+    const BufferBinding weight = buffers.Binding(weights[i]);
+    queue.WriteBuffer(weight.buffer, weight.offset, workload.weights[i].data(),
+                      weightSize);
+  }
+
+  GemmPipeline gemm(device, allocator);
+  wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+  wgpu::ComputePassEncoder passEncoder = commandEncoder.BeginComputePass();
+  for (uint32_t i = 0; i < workload.layers; ++i) {
+    gemm.Dispatch(passEncoder, buffers.Binding(activations[i]),
+                  buffers.Binding(weights[i]),
+                  buffers.Binding(activations[i + 1]), workload.batch,
+                  workload.width, workload.width);
+  }
+  passEncoder.End();
+  wgpu::CommandBuffer commands = commandEncoder.Finish();
+  queue.Submit(1, &commands);
+
+  std::vector<float> output =
+      ReadBack<float>(instance, allocator,
+                      buffers.Binding(activations[workload.layers]),
+                      activationSize);
+
+  std::cout << (alias ? "Aliased intermediates" : "One buffer per tensor")
+            << ": " << plan.allocationSizes.size() << " allocations, "
+            << plan.plannedBytes << " bytes planned (" << plan.naiveBytes
+            << " without aliasing)" << std::endl;
+  allocator.PrintReport(std::cout);
+  std::cout << std::endl;
+  return output;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Workload workload;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--batch") == 0) {
+      workload.batch = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--width") == 0) {
+      workload.width = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--layers") == 0) {
+      workload.layers = std::max(1, std::atoi(argv[i + 1]));
+    }
+  }
+
+  instance = wgpu::CreateInstance();
+  wgpu::Adapter adapter = RequestAdapterSync(instance);
+  std::cout << "GPU Adapter acquired." << std::endl;
+  device = RequestDeviceSync(instance, adapter);
+  std::cout << "GPU Device acquired." << std::endl;
+
+  // Scale the weights so activations stay around 1 through the chain.
+  const float scale = std::sqrt(3.0f / workload.width);
+  workload.input =
+      RandomMatrix(size_t(workload.batch) * workload.width, 1.0f, 1);
+  for (uint32_t i = 0; i < workload.layers; ++i) {
+    workload.weights.push_back(
+        RandomMatrix(size_t(workload.width) * workload.width, scale, 2 + i));
+  }
+
+  const std::vector<float> naive = Run(workload, false);
+  const std::vector<float> planned = Run(workload, true);
+
+  for (size_t i = 0; i < naive.size(); ++i) {
+    if (naive[i] != planned[i]) {
+      std::cout << "Mismatch at " << i << ": " << naive[i]
+                << " != " << planned[i] << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "Aliased run matches the unaliased run." << std::endl;
+  return 0;
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "DeviceHelpers.h"
+#include "RadixSort.h"
+#include "Scan.h"
+#include "TrackedAllocator.h"
+
+// Checks the device-wide scan and the radix sort against the CPU, then
+// reports their throughput in keys per second for growing inputs, next to
+// std::sort on one core.
+//
+// Usage: sort-bench [--max-elements N] [--iterations I]
+
+namespace {
+
+wgpu::Instance instance;
+wgpu::Device device;
+
+std::vector<uint32_t> RandomKeys(size_t count, uint32_t range, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<uint32_t> dist(0, range);
+  std::vector<uint32_t> keys(count);
+  for (uint32_t &key : keys) {
+    key = dist(rng);
+  }
+  return keys;
+}
+
+TrackedBuffer Upload(TrackedAllocator &allocator,
+                     const std::vector<uint32_t> &data) {
+  wgpu::BufferDescriptor descriptor{
+      .usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc |
+               wgpu::BufferUsage::CopyDst,
+      .size = data.size() * sizeof(uint32_t),
+  };
+  TrackedBuffer buffer = allocator.CreateBuffer(descriptor);
+  device.GetQueue().WriteBuffer(buffer.Get(), 0, data.data(), descriptor.size);
+  return buffer;
+}
+
+// Seconds per call of `encode` (which records one operation), after a
+// warm-up call.
+double Time(const std::function<void(const wgpu::CommandEncoder &)> &encode,
+            uint32_t iterations) {
+  auto submit = [&](uint32_t count) {
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    for (uint32_t i = 0; i < count; ++i) {
+      encode(commandEncoder);
+    }
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+  };
+  submit(1);
+  WaitForQueue(instance, device);
+  const auto start = std::chrono::steady_clock::now();
+  submit(iterations);
+  WaitForQueue(instance, device);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count() /
+         iterations;
+}
+
+bool VerifyScan(uint32_t count) {
+  TrackedAllocator allocator(device);
+  const std::vector<uint32_t> input = RandomKeys(count, 100, 1);
+  TrackedBuffer inputBuffer = Upload(allocator, input);
+  TrackedBuffer outputBuffer = Upload(allocator, input);
+  Scan scan(device, allocator, count);
+
+  for (ScanKind kind : {ScanKind::Exclusive, ScanKind::Inclusive}) {
+    std::vector<uint32_t> expected(count);
+    if (kind == ScanKind::Exclusive) {
+      std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+    } else {
+      std::inclusive_scan(input.begin(), input.end(), expected.begin());
+    }
+    wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+    scan.Encode(commandEncoder, {.buffer = inputBuffer.Get()},
+                {.buffer = outputBuffer.Get()}, kind);
+    wgpu::CommandBuffer commands = commandEncoder.Finish();
+    device.GetQueue().Submit(1, &commands);
+    if (ReadBack<uint32_t>(instance, allocator,
+                           {.buffer = outputBuffer.Get()},
+                           count * sizeof(uint32_t)) != expected) {
+      std::cout << (kind == ScanKind::Exclusive ? "Exclusive" : "Inclusive")
+                << " scan of " << count << " values is wrong" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// A narrow key range gives plenty of duplicates, so the values (original
+// positions) also check that the sort is stable.
+bool VerifySort(uint32_t count) {
+  TrackedAllocator allocator(device);
+  const std::vector<uint32_t> keys = RandomKeys(count, 1000, 2);
+  std::vector<uint32_t> values(count);
+  std::iota(values.begin(), values.end(), 0u);
+  std::vector<uint32_t> order = values;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+  std::vector<uint32_t> expectedKeys(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    expectedKeys[i] = keys[order[i]];
+  }
+
+  TrackedBuffer keyBuffer = Upload(allocator, keys);
+  TrackedBuffer valueBuffer = Upload(allocator, values);
+  RadixSort sort(device, allocator, count, true);
+  wgpu::CommandEncoder commandEncoder = device.CreateCommandEncoder();
+  const BufferBinding valueBinding{.buffer = valueBuffer.Get()};
+  sort.Encode(commandEncoder, {.buffer = keyBuffer.Get()}, &valueBinding);
+  wgpu::CommandBuffer commands = commandEncoder.Finish();
+  device.GetQueue().Submit(1, &commands);
+
+  const uint64_t size = count * sizeof(uint32_t);
+  if (ReadBack<uint32_t>(instance, allocator, {.buffer = keyBuffer.Get()},
+                         size) != expectedKeys ||
+      ReadBack<uint32_t>(instance, allocator, {.buffer = valueBuffer.Get()},
+                         size) != order) {
+    std::cout << "Sort of " << count << " key-value pairs is wrong"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint64_t maxElements = 100'000'000;
+  uint32_t iterations = 5;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--max-elements") == 0) {
+      maxElements = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--iterations") == 0) {
+      iterations = std::max(1, std::atoi(argv[i + 1]));
+    }
+  }
+
+  instance = wgpu::CreateInstance();
+  wgpu::Adapter adapter = RequestAdapterSync(instance);
+  std::cout << "GPU Adapter acquired." << std::endl;
+
+  // 100M keys take 400 MB per buffer, well past the default 128 MiB binding
+  // limit, so ask for everything the adapter supports.
+  wgpu::SupportedLimits supported = {};
+  adapter.GetLimits(&supported);
+  wgpu::RequiredLimits required{.limits = supported.limits};
+  wgpu::DeviceDescriptor deviceDesc{.requiredLimits = &required};
+  device = RequestDeviceSync(instance, adapter, &deviceDesc);
+  std::cout << "GPU Device acquired." << std::endl;
+
+  const uint64_t maxBinding = std::min(supported.limits.maxStorageBufferBindingSize,
+                                       supported.limits.maxBufferSize);
+  maxElements = std::min(maxElements, maxBinding / sizeof(uint32_t));
+
+  // Single tile, several tiles, and enough tiles for three scan levels.
+  for (uint32_t count : {1u, 1000u, 1025u, 5000u, 1'234'567u}) {
+    if (!VerifyScan(count) || !VerifySort(count)) {
+      return 1;
+    }
+  }
+  std::cout << "Scan and sort verified against the CPU." << std::endl;
+
+  std::cout << "elements     scan Mkeys/s   sort Mkeys/s   sort kv Mkeys/s   "
+               "std::sort Mkeys/s"
+            << std::endl;
+  for (uint64_t count = 1'000'000; count <= maxElements; count *= 10) {
+    TrackedAllocator allocator(device);
+    const std::vector<uint32_t> keys =
+        RandomKeys(count, UINT32_MAX, unsigned(count));
+    TrackedBuffer keyBuffer = Upload(allocator, keys);
+
+    // Each primitive's buffers are dropped before the next one is created,
+    // so the largest size only needs room for one of them at a time.
+    double scanSeconds = 0.0;
+    {
+      TrackedBuffer scanBuffer = Upload(allocator, keys);
+      Scan scan(device, allocator, uint32_t(count));
+      scanSeconds = Time(
+          [&](const wgpu::CommandEncoder &encoder) {
+            scan.Encode(encoder, {.buffer = keyBuffer.Get()},
+                        {.buffer = scanBuffer.Get()}, ScanKind::Exclusive);
+          },
+          iterations);
+    }
+
+    // Re-sorting sorted keys costs the same as sorting random ones: every
+    // pass does the same work whatever the order.
+    double sortSeconds = 0.0;
+    {
+      RadixSort sort(device, allocator, uint32_t(count));
+      sortSeconds = Time(
+          [&](const wgpu::CommandEncoder &encoder) {
+            sort.Encode(encoder, {.buffer = keyBuffer.Get()});
+          },
+          iterations);
+    }
+
+    double pairSeconds = 0.0;
+    {
+      TrackedBuffer valueBuffer = Upload(allocator, keys);
+      RadixSort sort(device, allocator, uint32_t(count), true);
+      const BufferBinding valueBinding{.buffer = valueBuffer.Get()};
+      pairSeconds = Time(
+          [&](const wgpu::CommandEncoder &encoder) {
+            sort.Encode(encoder, {.buffer = keyBuffer.Get()}, &valueBinding);
+          },
+          iterations);
+    }
+
+    std::vector<uint32_t> cpuKeys = keys;
+    const auto start = std::chrono::steady_clock::now();
+    std::sort(cpuKeys.begin(), cpuKeys.end());
+    const double cpuSeconds = std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+
+    std::cout << count << "\t\t" << count / scanSeconds * 1e-6 << "\t\t"
+              << count / sortSeconds * 1e-6 << "\t\t"
+              << count / pairSeconds * 1e-6 << "\t\t"
+              << count / cpuSeconds * 1e-6 << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <webgpu/webgpu_cpp.h>
+
+#include "DeviceHelpers.h"
+#include "TrackedAllocator.h"
+#include "UploadEngine.h"
+
+// Upload bandwidth of each UploadEngine strategy across transfer sizes, the
+// strategy the startup calibration picks for each size, and how the parallel
+// copy into mapped memory scales with worker threads.
+//
+// Usage: upload-bench [--max-size MB] [--threads T]
+
+int main(int argc, char **argv) {
+  uint64_t maxSize = uint64_t(256) << 20;
+  uint32_t threads = 3;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--max-size") == 0) {
+      maxSize = uint64_t(std::max(1, std::atoi(argv[i + 1]))) << 20;
+    } else if (std::strcmp(argv[i], "--threads") == 0) {
+      threads = std::max(0, std::atoi(argv[i + 1]));
+    }
+  }
+
+  wgpu::Instance instance = wgpu::CreateInstance();
+  wgpu::Adapter adapter = RequestAdapterSync(instance);
+  std::cout << "GPU Adapter acquired." << std::endl;
+  wgpu::Device device = RequestDeviceSync(instance, adapter);
+  std::cout << "GPU Device acquired." << std::endl;
+
+  wgpu::SupportedLimits limits = {};
+  device.GetLimits(&limits);
+  maxSize = std::min(maxSize, limits.limits.maxBufferSize);
+
+  TrackedAllocator allocator(device);
+  UploadEngine engine(instance, device, allocator,
+                      UploadEngine::Options{.copyThreads = threads});
+
+  std::cout << "Calibration:" << std::endl;
+  for (const auto &[size, strategy] : engine.GetCalibration()) {
+    std::cout << "  >= " << size / 1024 << " KiB: "
+              << UploadStrategyName(strategy) << std::endl;
+  }
+
+  std::cout << "size KiB    WriteBuffer GB/s   MappedAtCreation GB/s   "
+               "StagingRing GB/s   chosen"
+            << std::endl;
+  for (uint64_t size = 4 << 10; size <= maxSize; size *= 4) {
+    std::cout << size / 1024;
+    for (UploadStrategy strategy :
+         {UploadStrategy::WriteBuffer, UploadStrategy::MappedAtCreation,
+          UploadStrategy::StagingRing}) {
+      std::cout << "\t\t" << engine.MeasureBandwidth(strategy, size) * 1e-9;
+    }
+    std::cout << "\t\t" << UploadStrategyName(engine.Choose(size))
+              << std::endl;
+  }
+
+  // Large transfers are bound by the copy into mapped memory; compare one
+  // thread with the pool.
+  const uint64_t largeSize = std::min<uint64_t>(maxSize, uint64_t(64) << 20);
+  std::cout << "MappedAtCreation, " << largeSize / (1024 * 1024)
+            << " MiB:" << std::endl;
+  for (uint32_t count : {0u, threads}) {
+    UploadEngine scaling(
+        instance, device, allocator,
+        UploadEngine::Options{.copyThreads = count, .calibrate = false});
+    std::cout << "  " << count + 1 << " thread(s): "
+              << scaling.MeasureBandwidth(UploadStrategy::MappedAtCreation,
+                                          largeSize) *
+                     1e-9
+              << " GB/s" << std::endl;
+  }
+
+  allocator.PrintReport(std::cout);
+  return 0;
+}